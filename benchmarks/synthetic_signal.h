@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include <tau/random.h>
+#include <tau/angles.h>
+#include <tau/eigen.h>
+
+
+/**
+ ** A signal with the features that matter to wavelet compression: a slow
+ ** carrier, bursts of high frequency energy, flat stretches, steps, and
+ ** uniform noise. Feature positions scale with length, so every length has
+ ** the same proportions.
+ **/
+inline
+Eigen::RowVector<double, Eigen::Dynamic> MakeSyntheticSignal(
+    Eigen::Index length,
+    tau::Seed seed)
+{
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+    using Eigen::Index;
+    using Eigen::seqN;
+
+    auto pi = tau::Angles<double>::pi;
+    RowVector x = RowVector::LinSpaced(length, 0, 2 * pi);
+
+    // Cycle counts grow with length, so the bursts keep a fixed number of
+    // samples per cycle.
+    auto scale = static_cast<double>(length) / 1024.0;
+
+    RowVector y = 100 * Eigen::sin(2 * x.array() - pi / 8);
+    RowVector p = 900 * Eigen::cos(300 * scale * x.array());
+    RowVector q = 75 * Eigen::cos(101 * scale * x.array());
+    RowVector r = 50 * Eigen::cos(72 * scale * x.array());
+
+    auto at = [length](double fraction)
+    {
+        return static_cast<Index>(fraction * static_cast<double>(length));
+    };
+
+    for (auto [start, width, u]: {
+            std::make_tuple(at(0.13), at(0.35), &p),
+            std::make_tuple(at(0.19), at(0.21), &q),
+            std::make_tuple(at(0.23), at(0.24), &r)})
+    {
+        y(seqN(start, width)) += (*u)(seqN(start, width));
+    }
+
+    y(seqN(0, at(0.15))).array() = 0;
+    y(seqN(at(0.3), at(0.2))).array() = 0;
+
+    // Steps
+    y(seqN(at(0.5), at(0.2))).array() += 400;
+    y(seqN(at(0.7), at(0.3) - 1)).array() -= 250;
+
+    auto random = tau::UniformRandom<double>(seed, -5, 5);
+
+    for (Index i = 0; i < y.size(); ++i)
+    {
+        y(i) += random();
+    }
+
+    return y;
+}
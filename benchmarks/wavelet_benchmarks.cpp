@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+#include <tau/compression_pipeline.h>
+
+#include "synthetic_signal.h"
+
+
+/**
+ ** Measures the wavelet codec across wavelets, signal lengths, keep ratios,
+ ** and zero run codings.
+ **
+ ** Throughput is reported in MB/s of input samples (8 bytes each), using the
+ ** fastest of the repeated runs to reduce scheduling noise.
+ **/
+
+
+struct BenchmarkOptions
+{
+    std::string format = "text";
+    size_t repeatCount = 5;
+    tau::Seed seed = 42;
+    bool quick = false;
+};
+
+
+struct BenchmarkResult
+{
+    std::string wavelet;
+    Eigen::Index signalLength;
+    double keepRatio;
+    bool enableMultibyteZeros;
+    size_t encodedByteCount;
+    double compressionRatio;
+    double rmsError;
+    double encodeMegabytesPerSecond;
+    double decodeMegabytesPerSecond;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&BenchmarkResult::wavelet, "wavelet"),
+        fields::Field(&BenchmarkResult::signalLength, "signalLength"),
+        fields::Field(&BenchmarkResult::keepRatio, "keepRatio"),
+        fields::Field(
+            &BenchmarkResult::enableMultibyteZeros,
+            "enableMultibyteZeros"),
+        fields::Field(&BenchmarkResult::encodedByteCount, "encodedByteCount"),
+        fields::Field(&BenchmarkResult::compressionRatio, "compressionRatio"),
+        fields::Field(&BenchmarkResult::rmsError, "rmsError"),
+        fields::Field(
+            &BenchmarkResult::encodeMegabytesPerSecond,
+            "encodeMegabytesPerSecond"),
+        fields::Field(
+            &BenchmarkResult::decodeMegabytesPerSecond,
+            "decodeMegabytesPerSecond"));
+};
+
+
+using Clock = std::chrono::steady_clock;
+
+
+// Returns the fastest run of function, in seconds.
+template<typename Function>
+double TimeFastest(size_t repeatCount, Function &&function)
+{
+    double fastest = std::numeric_limits<double>::max();
+
+    for (size_t i = 0; i < repeatCount; ++i)
+    {
+        auto start = Clock::now();
+        function();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        fastest = std::min(fastest, elapsed.count());
+    }
+
+    return fastest;
+}
+
+
+BenchmarkResult RunBenchmark(
+    const Eigen::RowVector<double, Eigen::Dynamic> &signal,
+    const tau::CompressionSettings &settings,
+    size_t repeatCount)
+{
+    auto wavelet = tau::GetWavelet<double>(settings.wavelet);
+    std::string chunk;
+
+    double encodeSeconds = TimeFastest(
+        repeatCount,
+        [&]()
+        {
+            chunk = tau::CompressSegment(wavelet, signal, settings);
+        });
+
+    Eigen::RowVector<double, Eigen::Dynamic> recovered;
+
+    double decodeSeconds = TimeFastest(
+        repeatCount,
+        [&]()
+        {
+            std::istringstream input(chunk);
+
+            recovered = tau::DecompressSegment(
+                wavelet,
+                input,
+                settings.reflect,
+                settings.enableMultibyteZeros);
+        });
+
+    auto inputByteCount =
+        static_cast<double>(signal.size()) * sizeof(double);
+
+    auto megabytes = inputByteCount / 1e6;
+
+    return {
+        tau::WaveletNameConverter::ToString(settings.wavelet),
+        signal.size(),
+        settings.keepRatio,
+        settings.enableMultibyteZeros,
+        chunk.size(),
+        inputByteCount / static_cast<double>(chunk.size()),
+        tau::GetRms(recovered - signal),
+        megabytes / encodeSeconds,
+        megabytes / decodeSeconds};
+}
+
+
+void PrintText(const std::vector<BenchmarkResult> &results)
+{
+    std::cout << fmt::format(
+        "{:>8} {:>9} {:>6} {:>9} {:>10} {:>8} {:>10} {:>10} {:>10}\n",
+        "wavelet",
+        "length",
+        "keep",
+        "multibyte",
+        "bytes",
+        "ratio",
+        "rms",
+        "enc MB/s",
+        "dec MB/s");
+
+    for (auto &result: results)
+    {
+        std::cout << fmt::format(
+            "{:>8} {:>9} {:>6.3f} {:>9} {:>10} {:>8.2f} {:>10.4f} "
+            "{:>10.1f} {:>10.1f}\n",
+            result.wavelet,
+            result.signalLength,
+            result.keepRatio,
+            result.enableMultibyteZeros,
+            result.encodedByteCount,
+            result.compressionRatio,
+            result.rmsError,
+            result.encodeMegabytesPerSecond,
+            result.decodeMegabytesPerSecond);
+    }
+}
+
+
+void PrintCsv(const std::vector<BenchmarkResult> &results)
+{
+    std::cout << "wavelet,signalLength,keepRatio,enableMultibyteZeros,"
+        "encodedByteCount,compressionRatio,rmsError,"
+        "encodeMegabytesPerSecond,decodeMegabytesPerSecond\n";
+
+    for (auto &result: results)
+    {
+        std::cout << fmt::format(
+            "{},{},{},{},{},{},{},{},{}\n",
+            result.wavelet,
+            result.signalLength,
+            result.keepRatio,
+            static_cast<int>(result.enableMultibyteZeros),
+            result.encodedByteCount,
+            result.compressionRatio,
+            result.rmsError,
+            result.encodeMegabytesPerSecond,
+            result.decodeMegabytesPerSecond);
+    }
+}
+
+
+void PrintJson(const std::vector<BenchmarkResult> &results)
+{
+    auto unstructured = nlohmann::json::array();
+
+    for (auto &result: results)
+    {
+        unstructured.push_back(
+            fields::Unstructure<nlohmann::json>(result));
+    }
+
+    std::cout << unstructured.dump(4) << std::endl;
+}
+
+
+void PrintUsage(const char *name)
+{
+    std::cerr << "Usage: " << name
+        << " [--format text|csv|json] [--repeat count] [--seed seed]"
+        << " [--quick]" << std::endl;
+}
+
+
+std::optional<BenchmarkOptions> ParseOptions(int count, char **args)
+{
+    BenchmarkOptions options;
+
+    for (int i = 1; i < count; ++i)
+    {
+        std::string argument = args[i];
+
+        if (argument == "--quick")
+        {
+            options.quick = true;
+            continue;
+        }
+
+        if (i + 1 >= count)
+        {
+            return {};
+        }
+
+        std::string value = args[++i];
+
+        if (argument == "--format")
+        {
+            if (value != "text" && value != "csv" && value != "json")
+            {
+                return {};
+            }
+
+            options.format = value;
+        }
+        else if (argument == "--repeat")
+        {
+            options.repeatCount = std::max<size_t>(std::stoul(value), 1);
+        }
+        else if (argument == "--seed")
+        {
+            options.seed = static_cast<tau::Seed>(std::stoul(value));
+        }
+        else
+        {
+            return {};
+        }
+    }
+
+    return options;
+}
+
+
+int main(int count, char **args)
+{
+    std::optional<BenchmarkOptions> options;
+
+    try
+    {
+        options = ParseOptions(count, args);
+    }
+    catch (std::logic_error &)
+    {
+        // std::stoul throws on values that are not numbers.
+    }
+
+    if (!options)
+    {
+        PrintUsage(args[0]);
+        return 1;
+    }
+
+    std::vector<Eigen::Index> signalLengths{1024, 16384, 262144};
+    std::vector<double> keepRatios{0.01, 0.05, 0.2};
+
+    if (options->quick)
+    {
+        signalLengths = {4096};
+        keepRatios = {0.05};
+    }
+
+    std::vector<BenchmarkResult> results;
+
+    for (auto signalLength: signalLengths)
+    {
+        auto signal = MakeSyntheticSignal(signalLength, options->seed);
+
+        for (auto waveletName: tau::GetWaveletNames())
+        {
+            for (auto keepRatio: keepRatios)
+            {
+                for (bool enableMultibyteZeros: {false, true})
+                {
+                    auto settings = tau::CompressionSettings::Default();
+                    settings.wavelet = waveletName;
+                    settings.keepRatio = keepRatio;
+                    settings.enableMultibyteZeros = enableMultibyteZeros;
+
+                    results.push_back(
+                        RunBenchmark(signal, settings, options->repeatCount));
+                }
+            }
+        }
+    }
+
+    if (options->format == "csv")
+    {
+        PrintCsv(results);
+    }
+    else if (options->format == "json")
+    {
+        PrintJson(results);
+    }
+    else
+    {
+        PrintText(results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,375 @@
+#include "tau/bayer.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+
+namespace tau
+{
+
+
+namespace detail
+{
+
+
+using Index = Eigen::Index;
+
+
+// Rows are demosaiced in blocks of columns computed into local arrays, which
+// the compiler knows are not aliased, so the arithmetic is vectorized.
+static constexpr Index blockSize = 256;
+
+// Mirrored samples on each side of a padded row.
+static constexpr Index border = 2;
+
+
+// Mirrors without repeating the edge, so a sample outside the mosaic has the
+// color of the sample it copies.
+Index MirrorIndex(Index index, Index count)
+{
+    if (index < 0)
+    {
+        return -index;
+    }
+
+    if (index >= count)
+    {
+        return 2 * (count - 1) - index;
+    }
+
+    return index;
+}
+
+
+template<typename T>
+void LoadPaddedRow(const MosaicSamples<T> &mosaic, Index row, T *padded)
+{
+    const Index width = mosaic.size.width;
+
+    const T *source =
+        mosaic.data + MirrorIndex(row, mosaic.size.height) * mosaic.stride;
+
+    std::copy_n(source, width, padded + border);
+
+    padded[0] = source[2];
+    padded[1] = source[1];
+    padded[border + width] = source[width - 2];
+    padded[border + width + 1] = source[width - 3];
+}
+
+
+/**
+ ** The estimates of a missing color are weighted sums of the 5 x 5
+ ** neighborhood, scaled by 16:
+ **
+ **     center   the sample itself
+ **     h1, h2   the samples one and two columns to either side
+ **     v1, v2   the samples one and two rows above and below
+ **     d        the four diagonal neighbors
+ **
+ ** Bilinear uses only the neighbors of the missing color. Malvar-He-Cutler
+ ** adds the Laplacian of the known color.
+ **/
+template<bool malvar>
+struct Estimates
+{
+    // Green where red or blue is known.
+    static int32_t Green(
+        int32_t center,
+        int32_t h1,
+        int32_t v1,
+        int32_t h2,
+        int32_t v2)
+    {
+        if constexpr (malvar)
+        {
+            return 8 * center + 4 * (h1 + v1) - 2 * (h2 + v2);
+        }
+        else
+        {
+            return 4 * (h1 + v1);
+        }
+    }
+
+    // Blue where red is known, or red where blue is known.
+    static int32_t Opposite(
+        int32_t center,
+        int32_t h2,
+        int32_t v2,
+        int32_t d)
+    {
+        if constexpr (malvar)
+        {
+            return 12 * center + 4 * d - 3 * (h2 + v2);
+        }
+        else
+        {
+            return 4 * d;
+        }
+    }
+
+    // At green, the color known to either side. The color known above and
+    // below uses the same weights with h and v exchanged.
+    static int32_t Beside(
+        int32_t center,
+        int32_t h1,
+        int32_t h2,
+        int32_t v2,
+        int32_t d)
+    {
+        if constexpr (malvar)
+        {
+            return 10 * center + 8 * h1 - 2 * h2 - 2 * d + v2;
+        }
+        else
+        {
+            return 8 * h1;
+        }
+    }
+};
+
+
+template<typename T>
+T Normalize(int32_t estimate, int32_t maximum)
+{
+    return static_cast<T>(std::clamp((estimate + 8) >> 4, 0, maximum));
+}
+
+
+/**
+ ** Demosaics one row, in which the samples in columns of parity phase have
+ ** the color written to own, and the others are green. other receives the
+ ** color known only in the rows above and below.
+ **
+ ** rows point to the first sample of the padded rows from two above to two
+ ** below.
+ **/
+template<bool malvar, Index phase, typename T>
+void DemosaicRow_(
+    const std::array<const T *, 5> &rows,
+    Index width,
+    int32_t maximum,
+    T *own,
+    T *green,
+    T *other)
+{
+    using Estimate = Estimates<malvar>;
+
+    // The vertical sums are shared by neighboring columns, so the diagonal
+    // sums are formed from them in a separate horizontal pass. vertical1
+    // starts one column before the block.
+    int32_t vertical1[blockSize + 2];
+    int32_t vertical2[blockSize];
+
+    T ownBlock[blockSize];
+    T greenBlock[blockSize];
+    T otherBlock[blockSize];
+
+    for (Index first = 0; first < width; first += blockSize)
+    {
+        Index count = std::min(blockSize, width - first);
+
+        const T *above2 = rows[0] + first;
+        const T *above1 = rows[1] + first;
+        const T *center = rows[2] + first;
+        const T *below1 = rows[3] + first;
+        const T *below2 = rows[4] + first;
+
+        for (Index i = -1; i < count + 1; ++i)
+        {
+            vertical1[i + 1] = above1[i] + below1[i];
+        }
+
+        for (Index i = 0; i < count; ++i)
+        {
+            vertical2[i] = above2[i] + below2[i];
+        }
+
+        // Each pair of columns holds one sample of each kind.
+        for (Index i = 0; i < count; i += 2)
+        {
+            Index known = i + phase;
+            Index between = i + 1 - phase;
+
+            int32_t value = center[known];
+            int32_t h1 = center[known - 1] + center[known + 1];
+            int32_t h2 = center[known - 2] + center[known + 2];
+            int32_t v1 = vertical1[known + 1];
+            int32_t v2 = vertical2[known];
+            int32_t d = vertical1[known] + vertical1[known + 2];
+
+            ownBlock[known] = static_cast<T>(value);
+
+            greenBlock[known] = Normalize<T>(
+                Estimate::Green(value, h1, v1, h2, v2),
+                maximum);
+
+            otherBlock[known] = Normalize<T>(
+                Estimate::Opposite(value, h2, v2, d),
+                maximum);
+
+            value = center[between];
+            h1 = center[between - 1] + center[between + 1];
+            h2 = center[between - 2] + center[between + 2];
+            v1 = vertical1[between + 1];
+            v2 = vertical2[between];
+            d = vertical1[between] + vertical1[between + 2];
+
+            greenBlock[between] = static_cast<T>(value);
+
+            ownBlock[between] = Normalize<T>(
+                Estimate::Beside(value, h1, h2, v2, d),
+                maximum);
+
+            otherBlock[between] = Normalize<T>(
+                Estimate::Beside(value, v1, v2, h2, d),
+                maximum);
+        }
+
+        std::copy_n(ownBlock, count, own + first);
+        std::copy_n(greenBlock, count, green + first);
+        std::copy_n(otherBlock, count, other + first);
+    }
+}
+
+
+template<typename T>
+using DemosaicRowFunction = void (*)(
+    const std::array<const T *, 5> &,
+    Index,
+    int32_t,
+    T *,
+    T *,
+    T *);
+
+
+template<bool malvar, typename T>
+DemosaicRowFunction<T> GetDemosaicRow(Index phase)
+{
+    if (phase == 0)
+    {
+        return &DemosaicRow_<malvar, 0, T>;
+    }
+
+    return &DemosaicRow_<malvar, 1, T>;
+}
+
+
+// The row and column parity of the red samples.
+std::array<Index, 2> GetRedPhase(BayerPattern pattern)
+{
+    switch (pattern)
+    {
+        case BayerPattern::rggb:
+            return {0, 0};
+
+        case BayerPattern::bggr:
+            return {1, 1};
+
+        case BayerPattern::grbg:
+            return {0, 1};
+
+        case BayerPattern::gbrg:
+            return {1, 0};
+
+        default:
+            throw std::invalid_argument("Unknown BayerPattern");
+    }
+}
+
+
+template<typename T>
+void DemosaicRows_(
+    const MosaicSamples<T> &mosaic,
+    const DemosaicPlanes<T> &planes,
+    const DemosaicSettings &settings,
+    Index firstRow,
+    Index rowCount)
+{
+    const Index width = mosaic.size.width;
+    const Index paddedWidth = width + 2 * border;
+    const auto maximum = static_cast<int32_t>((1u << settings.bitDepth) - 1);
+    const auto [redRow, redColumn] = GetRedPhase(settings.pattern);
+
+    bool malvar = settings.method == DemosaicMethod::malvarHeCutler;
+
+    // Rows with red, and rows with blue.
+    auto redRowFunction = malvar
+        ? GetDemosaicRow<true, T>(redColumn)
+        : GetDemosaicRow<false, T>(redColumn);
+
+    auto blueRowFunction = malvar
+        ? GetDemosaicRow<true, T>(1 - redColumn)
+        : GetDemosaicRow<false, T>(1 - redColumn);
+
+    // Each band keeps the five rows around the current one, so every row of
+    // the mosaic is loaded once.
+    std::vector<T> storage(static_cast<size_t>(5 * paddedWidth));
+    std::array<T *, 5> padded;
+
+    for (size_t i = 0; i < padded.size(); ++i)
+    {
+        auto index = static_cast<Index>(i);
+        padded[i] = storage.data() + index * paddedWidth;
+        LoadPaddedRow(mosaic, firstRow - 2 + index, padded[i]);
+    }
+
+    for (Index row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        if (row > firstRow)
+        {
+            std::rotate(padded.begin(), padded.begin() + 1, padded.end());
+            LoadPaddedRow(mosaic, row + 2, padded[4]);
+        }
+
+        std::array<const T *, 5> rows;
+
+        for (size_t i = 0; i < 5; ++i)
+        {
+            rows[i] = padded[i] + border;
+        }
+
+        Index offset = row * planes.stride;
+        T *red = planes.red + offset;
+        T *green = planes.green + offset;
+        T *blue = planes.blue + offset;
+
+        if (row % 2 == redRow)
+        {
+            redRowFunction(rows, width, maximum, red, green, blue);
+        }
+        else
+        {
+            blueRowFunction(rows, width, maximum, blue, green, red);
+        }
+    }
+}
+
+
+void DemosaicRows(
+    const MosaicSamples<uint8_t> &mosaic,
+    const DemosaicPlanes<uint8_t> &planes,
+    const DemosaicSettings &settings,
+    Index firstRow,
+    Index rowCount)
+{
+    DemosaicRows_(mosaic, planes, settings, firstRow, rowCount);
+}
+
+
+void DemosaicRows(
+    const MosaicSamples<uint16_t> &mosaic,
+    const DemosaicPlanes<uint16_t> &planes,
+    const DemosaicSettings &settings,
+    Index firstRow,
+    Index rowCount)
+{
+    DemosaicRows_(mosaic, planes, settings, firstRow, rowCount);
+}
+
+
+} // end namespace detail
+
+
+} // end namespace tau
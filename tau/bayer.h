@@ -0,0 +1,254 @@
+#pragma once
+
+
+#include <cstdint>
+#include <stdexcept>
+#include <fields/fields.h>
+
+#include "tau/eigen.h"
+#include "tau/size.h"
+#include "tau/planar.h"
+#include "tau/row_bands.h"
+
+
+namespace tau
+{
+
+
+// The colors of the top-left 2 x 2 block of the mosaic, in row-major order.
+enum class BayerPattern
+{
+    rggb,
+    bggr,
+    grbg,
+    gbrg
+};
+
+
+enum class DemosaicMethod
+{
+    // Averages of the nearest samples of each missing color.
+    bilinear,
+
+    // Bilinear corrected by the gradient of the known color (Malvar, He, and
+    // Cutler, 2004), which keeps edges sharper with the same 5 x 5 support.
+    malvarHeCutler
+};
+
+
+struct DemosaicSettings
+{
+    BayerPattern pattern;
+    DemosaicMethod method;
+
+    // The significant bits of each sample, such as 12 for a 12-bit sensor
+    // read into uint16_t. Results are clamped to the same range.
+    int bitDepth;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&DemosaicSettings::pattern, "pattern"),
+        fields::Field(&DemosaicSettings::method, "method"),
+        fields::Field(&DemosaicSettings::bitDepth, "bitDepth"));
+};
+
+
+template<typename T>
+using BayerPlanar =
+    Planar<3, T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+
+namespace detail
+{
+
+
+template<typename T>
+struct MosaicSamples
+{
+    const T *data;
+    Size<Eigen::Index> size;
+
+    // The count of samples between rows.
+    Eigen::Index stride;
+};
+
+
+template<typename T>
+struct DemosaicPlanes
+{
+    T *red;
+    T *green;
+    T *blue;
+    Eigen::Index stride;
+};
+
+
+void DemosaicRows(
+    const MosaicSamples<uint8_t> &mosaic,
+    const DemosaicPlanes<uint8_t> &planes,
+    const DemosaicSettings &settings,
+    Eigen::Index firstRow,
+    Eigen::Index rowCount);
+
+
+void DemosaicRows(
+    const MosaicSamples<uint16_t> &mosaic,
+    const DemosaicPlanes<uint16_t> &planes,
+    const DemosaicSettings &settings,
+    Eigen::Index firstRow,
+    Eigen::Index rowCount);
+
+
+template<typename T>
+void RequireDemosaicSettings(
+    const Size<Eigen::Index> &size,
+    const DemosaicSettings &settings)
+{
+    if (size.width % 2 != 0 || size.height % 2 != 0)
+    {
+        throw std::invalid_argument(
+            "A Bayer mosaic requires an even width and height");
+    }
+
+    if (size.width < 4 || size.height < 4)
+    {
+        throw std::invalid_argument(
+            "A Bayer mosaic must be at least 4 x 4");
+    }
+
+    if (
+        settings.bitDepth < 1
+        || settings.bitDepth > static_cast<int>(8 * sizeof(T)))
+    {
+        throw std::invalid_argument("bitDepth does not fit the sample type");
+    }
+}
+
+
+template<typename Derived>
+auto GetMosaicSamples(const Eigen::MatrixBase<Derived> &bayer)
+{
+    using T = typename Derived::Scalar;
+
+    static_assert(
+        std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>,
+        "Expected 8-bit or 16-bit samples");
+
+    static_assert(Derived::IsRowMajor, "Expected a row-major mosaic");
+
+    const auto &derived = bayer.derived();
+
+    return MosaicSamples<T>{
+        derived.data(),
+        Size<Eigen::Index>(derived.cols(), derived.rows()),
+        derived.outerStride()};
+}
+
+
+template<typename T, int rows, int columns, int options>
+DemosaicPlanes<T> GetDemosaicPlanes(
+    Planar<3, T, rows, columns, options> &rgb,
+    const Size<Eigen::Index> &size)
+{
+    static_assert(options & Eigen::RowMajor, "Expected row-major planes");
+
+    for (auto &plane: rgb.planes)
+    {
+        plane.resize(size.height, size.width);
+    }
+
+    return {
+        rgb.planes[0].data(),
+        rgb.planes[1].data(),
+        rgb.planes[2].data(),
+        size.width};
+}
+
+
+} // end namespace detail
+
+
+/**
+ ** Interpolates the two missing colors of each sample of a Bayer mosaic.
+ **
+ ** bayer is a row-major Eigen matrix of uint8_t or uint16_t, or a Map of a
+ ** frame buffer, with an even width and height. The planes of rgb are
+ ** resized to match it, which allocates nothing when they already do. The
+ ** overload that takes a ThreadPool demosaics bands of rows in parallel.
+ **
+ ** Samples beyond the edges are mirrored about the first and last rows and
+ ** columns, which keeps the colors of the mosaic in place.
+ **/
+template<typename Derived, typename T, int rows, int columns, int options>
+void Demosaic(
+    const Eigen::MatrixBase<Derived> &bayer,
+    Planar<3, T, rows, columns, options> &rgb,
+    const DemosaicSettings &settings)
+{
+    static_assert(std::is_same_v<T, typename Derived::Scalar>);
+
+    auto mosaic = detail::GetMosaicSamples(bayer);
+    detail::RequireDemosaicSettings<T>(mosaic.size, settings);
+
+    detail::DemosaicRows(
+        mosaic,
+        detail::GetDemosaicPlanes(rgb, mosaic.size),
+        settings,
+        0,
+        mosaic.size.height);
+}
+
+
+template<typename Derived, typename T, int rows, int columns, int options>
+void Demosaic(
+    const Eigen::MatrixBase<Derived> &bayer,
+    Planar<3, T, rows, columns, options> &rgb,
+    const DemosaicSettings &settings,
+    ThreadPool &threadPool)
+{
+    static_assert(std::is_same_v<T, typename Derived::Scalar>);
+
+    auto mosaic = detail::GetMosaicSamples(bayer);
+    detail::RequireDemosaicSettings<T>(mosaic.size, settings);
+    auto planes = detail::GetDemosaicPlanes(rgb, mosaic.size);
+
+    ForEachRowBand(
+        mosaic.size.height,
+        threadPool,
+        [&](Eigen::Index firstRow, Eigen::Index rowCount)
+        {
+            detail::DemosaicRows(
+                mosaic,
+                planes,
+                settings,
+                firstRow,
+                rowCount);
+        });
+}
+
+
+template<typename Derived>
+BayerPlanar<typename Derived::Scalar> Demosaic(
+    const Eigen::MatrixBase<Derived> &bayer,
+    const DemosaicSettings &settings)
+{
+    BayerPlanar<typename Derived::Scalar> result;
+    Demosaic(bayer, result, settings);
+
+    return result;
+}
+
+
+template<typename Derived>
+BayerPlanar<typename Derived::Scalar> Demosaic(
+    const Eigen::MatrixBase<Derived> &bayer,
+    const DemosaicSettings &settings,
+    ThreadPool &threadPool)
+{
+    BayerPlanar<typename Derived::Scalar> result;
+    Demosaic(bayer, result, settings, threadPool);
+
+    return result;
+}
+
+
+} // end namespace tau
@@ -0,0 +1,98 @@
+#include "tau/color.h"
+
+
+namespace tau
+{
+
+
+namespace
+{
+
+
+uint16_t Thousandths(double value)
+{
+    return static_cast<uint16_t>(std::lround(value * 1000.0));
+}
+
+
+} // end anonymous namespace
+
+
+HsvLookup::HsvLookup()
+    :
+    value_(tableSize),
+    saturation_(tableSize * tableSize),
+    hue_(tableSize * tableSize),
+    weights_(6 * sectorSteps + 1)
+{
+    for (size_t maximum = 0; maximum < tableSize; ++maximum)
+    {
+        this->value_[maximum] =
+            Thousandths(static_cast<double>(maximum) / 255.0);
+
+        for (size_t delta = 1; delta <= maximum; ++delta)
+        {
+            this->saturation_[maximum * tableSize + delta] = Thousandths(
+                static_cast<double>(delta) / static_cast<double>(maximum));
+        }
+    }
+
+    for (size_t delta = 1; delta < tableSize; ++delta)
+    {
+        for (size_t difference = 0; difference <= delta; ++difference)
+        {
+            this->hue_[delta * tableSize + difference] = Thousandths(
+                60.0 * static_cast<double>(difference)
+                    / static_cast<double>(delta));
+        }
+    }
+
+    for (size_t step = 0; step < this->weights_.size(); ++step)
+    {
+        auto position =
+            static_cast<double>(step) / static_cast<double>(sectorSteps);
+
+        auto x = static_cast<float>(
+            1.0 - std::abs(std::fmod(position, 2.0) - 1.0));
+
+        // 360 degrees falls in the last sector, as it does in HsvToRgb.
+        switch (std::min(step / sectorSteps, size_t{5}))
+        {
+            case 0:
+                this->weights_[step] = {1.0f, x, 0.0f};
+                break;
+
+            case 1:
+                this->weights_[step] = {x, 1.0f, 0.0f};
+                break;
+
+            case 2:
+                this->weights_[step] = {0.0f, 1.0f, x};
+                break;
+
+            case 3:
+                this->weights_[step] = {0.0f, x, 1.0f};
+                break;
+
+            case 4:
+                this->weights_[step] = {x, 0.0f, 1.0f};
+                break;
+
+            default:
+                this->weights_[step] = {1.0f, 0.0f, x};
+                break;
+        }
+    }
+}
+
+
+const HsvLookup & HsvLookup::Get()
+{
+    // Initialization of a local static is thread-safe.
+    static const HsvLookup lookup;
+
+    return lookup;
+}
+
+
+} // end namespace tau
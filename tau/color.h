@@ -1,11 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
 #include <fields/fields.h>
 #include <pex/group.h>
 
 #include "tau/eigen.h"
 #include "tau/planar.h"
+#include "tau/planar_view.h"
 #include "tau/angles.h"
 
 
@@ -55,8 +62,7 @@ struct Pixels
     static Pixels Create(const PlanarType &planar)
     {
         Pixels result;
-        result.size = planar.GetSize();
-        result.data = planar.GetInterleaved();
+        result.SetPlanar(planar);
 
         return result;
     }
@@ -92,7 +98,7 @@ struct Pixels
         std::memcpy(
             result.data.data(),
             initialData,
-            static_cast<size_t>(pixelCount) * componentCount);
+            static_cast<size_t>(pixelCount) * componentCount * sizeof(T));
 
         return result;
     }
@@ -109,10 +115,35 @@ struct Pixels
 
     PlanarType GetPlanar() const
     {
-        return PlanarType::FromInterleaved(
-            this->data,
-            this->size.height,
-            this->size.width);
+        PlanarType result(this->size);
+        result.ReadInterleaved(this->data.data());
+
+        return result;
+    }
+
+    // Reuses the storage of planar when it is already the right size.
+    void GetPlanar(PlanarType &planar) const
+    {
+        if (
+            planar.GetRowCount() != this->size.height
+            || planar.GetColumnCount() != this->size.width)
+        {
+            planar = PlanarType(this->size);
+        }
+
+        planar.ReadInterleaved(this->data.data());
+    }
+
+    // Reuses the storage of data when it is already the right size.
+    void SetPlanar(const PlanarType &planar)
+    {
+        this->size = planar.GetSize();
+
+        this->data.resize(
+            this->size.height * this->size.width,
+            static_cast<Index>(componentCount));
+
+        planar.WriteInterleaved(this->data.data());
     }
 };
 
@@ -126,6 +157,86 @@ template<typename T>
 using RgbaPixels = Pixels<T, 4>;
 
 
+/**
+ ** Pixels in a buffer owned by the caller, such as a frame from a capture
+ ** driver, used in place.
+ **
+ ** CreateShared attaches a release callback that runs after the last
+ ** shared_ptr is destroyed, so the buffer can be returned to its owner once
+ ** every consumer is done with it.
+ **/
+template<typename T, size_t componentCount>
+struct PixelsView
+{
+    using Data = Eigen::Map<ComponentMatrix<T, componentCount>>;
+    using Index = Eigen::Index;
+    using PlanarType = typename Pixels<T, componentCount>::PlanarType;
+    using Release = std::function<void(T *)>;
+
+    Data data;
+    Size<Index> size;
+
+    // buffer must hold componentCount samples for each pixel.
+    static PixelsView Create(T *buffer, const Size<Index> &size)
+    {
+        return {
+            Data(
+                buffer,
+                size.height * size.width,
+                static_cast<Index>(componentCount)),
+            size};
+    }
+
+    static std::shared_ptr<PixelsView> CreateShared(
+        T *buffer,
+        const Size<Index> &size,
+        Release release)
+    {
+        return std::shared_ptr<PixelsView>(
+            new PixelsView(Create(buffer, size)),
+            [release = std::move(release)](PixelsView *view)
+            {
+                T *released = view->data.data();
+                delete view;
+
+                if (release)
+                {
+                    release(released);
+                }
+            });
+    }
+
+    PlanarType GetPlanar() const
+    {
+        PlanarType result(this->size);
+        result.ReadInterleaved(this->data.data());
+
+        return result;
+    }
+
+    // planar must have the same size as the view.
+    void SetPlanar(const PlanarType &planar)
+    {
+        if (
+            planar.GetRowCount() != this->size.height
+            || planar.GetColumnCount() != this->size.width)
+        {
+            throw std::invalid_argument("planar size does not match");
+        }
+
+        planar.WriteInterleaved(this->data.data());
+    }
+};
+
+
+template<typename T>
+using RgbPixelsView = PixelsView<T, 3>;
+
+
+template<typename T>
+using RgbaPixelsView = PixelsView<T, 4>;
+
+
 namespace index
 {
     static constexpr size_t hue = 0;
@@ -418,98 +529,202 @@ Eigen::Vector<F, count> RgbToHsv(const Eigen::Vector<I, count> &rgb)
 }
 
 
-template
-<
-    typename F,
-    size_t count,
-    typename I,
-    int rows,
-    int columns,
-    int options
->
-auto RgbToHsv(const Planar<count, I, rows, columns, options> &rgb)
+namespace detail
 {
-    static_assert(std::is_floating_point_v<F>);
 
-    using PlanarT = Planar<count, F, rows, columns, options>;
-    using Matrix = typename PlanarT::Matrix;
-    using Array = ArrayLike<Matrix>;
 
-    PlanarT hsv(rgb.GetRowCount(), rgb.GetColumnCount());
+// Pixels are converted in blocks that stay in cache, so each plane is read
+// once and every intermediate is a short array that Eigen vectorizes.
+inline constexpr Eigen::Index hsvBlockSize = 256;
+
+
+template<typename F>
+using HsvBlock =
+    Eigen::Array<F, Eigen::Dynamic, 1, Eigen::ColMajor, hsvBlockSize, 1>;
 
-    PlanarT rgbFloat = rgb.template Cast<F>();
+
+template<typename F>
+using HsvBlockMap = Eigen::Map<Eigen::Array<F, Eigen::Dynamic, 1>>;
+
+
+template<typename F, typename I>
+HsvBlock<F> LoadHsvBlock(const I *data, Eigen::Index pixelCount)
+{
+    HsvBlock<F> result =
+        Eigen::Map<const Eigen::Array<I, Eigen::Dynamic, 1>>(
+            data,
+            pixelCount).template cast<F>();
 
     if constexpr (std::is_integral_v<I>)
     {
-        GetRed(rgbFloat).array() /= std::numeric_limits<I>::max();
-        GetGreen(rgbFloat).array() /= std::numeric_limits<I>::max();
-        GetBlue(rgbFloat).array() /= std::numeric_limits<I>::max();
-
-        if constexpr (count == 4)
-        {
-            GetAlpha(rgbFloat).array() /= std::numeric_limits<I>::max();
-        }
+        result /= static_cast<F>(std::numeric_limits<I>::max());
     }
 
-    typename PlanarT::ExtremaIndices indices(
-        rgb.GetRowCount(),
-        rgb.GetColumnCount());
+    return result;
+}
 
-    typename PlanarT::Extrema extrema;
 
-    if constexpr (count == 4)
+template<typename F, typename I>
+void StoreHsvBlock(const HsvBlock<F> &block, F *data)
+{
+    HsvBlockMap<F> target(data, block.size());
+
+    if constexpr (std::is_integral_v<I> && sizeof(I) <= 2)
     {
-        // Only the first three planes (red, green, and blue) are used in the
-        // conversion.
-        extrema = rgbFloat.GetExtrema(std::index_sequence<0, 1, 2>(), &indices);
+        // Round to 3 decimals for 8-bit input, and 6 decimals for 16-bit.
+        static constexpr F rounder = (sizeof(I) == 1)
+            ? static_cast<F>(jive::Power<10, 3>())
+            : static_cast<F>(jive::Power<10, 6>());
+
+        target = (block * rounder).round() / rounder;
     }
     else
     {
-        extrema = rgbFloat.GetExtrema(&indices);
+        target = block;
     }
+}
+
+
+template<typename F, typename I, size_t count>
+void RgbToHsvBlock(
+    const std::array<const I *, count> &rgb,
+    const std::array<F *, count> &hsv,
+    Eigen::Index offset,
+    Eigen::Index pixelCount)
+{
+    using Block = HsvBlock<F>;
+
+    Block red = LoadHsvBlock<F>(rgb[index::red] + offset, pixelCount);
+    Block green = LoadHsvBlock<F>(rgb[index::green] + offset, pixelCount);
+    Block blue = LoadHsvBlock<F>(rgb[index::blue] + offset, pixelCount);
+
+    Block maximum = red.max(green).max(blue);
+    Block delta = maximum - red.min(green).min(blue);
 
-    Array delta = extrema.planes[1] - extrema.planes[0];
+    // Ties go to the first maximum, as they do in maxCoeff.
+    auto isRedMaximum = (red >= green) && (red >= blue);
+    auto isGreenMaximum = (green > red) && (green >= blue);
 
-    auto mask0 = (indices.planes[1].array() == 0);
-    auto mask1 = (indices.planes[1].array() == 1);
+    Block hue = (delta == F{0}).select(
+        F{0},
+        isRedMaximum.select(
+            (green - blue) / delta,
+            isGreenMaximum.select(
+                F{2} + (blue - red) / delta,
+                F{4} + (red - green) / delta)));
 
-    GetHue(hsv) = (delta == 0.0).select(
-        0.0,
-        mask0.select(
-            (GetGreen(rgbFloat) - GetBlue(rgbFloat)).array() / delta,
-            mask1.select(
-                2 + (GetBlue(rgbFloat) - GetRed(rgbFloat)).array() / delta,
-                4 + (GetRed(rgbFloat) - GetGreen(rgbFloat)).array() / delta)));
+    // hue is positive, so floor matches the truncation in Modulo.
+    hue += F{6};
+    hue -= F{6} * (hue * (F{1} / F{6})).floor();
+    hue *= F{60};
 
-    GetHue(hsv) = GetHue(hsv).array() + 6.0;
-    GetHue(hsv) = 60.0 * tau::Modulo(GetHue(hsv), 6.0).array();
+    StoreHsvBlock<F, I>(hue, hsv[index::hue] + offset);
 
-    GetSaturation(hsv) =
-        (extrema.planes[1].array() == 0.0).select(
-            0.0,
-            delta / extrema.planes[1].array());
+    StoreHsvBlock<F, I>(
+        (maximum == F{0}).select(F{0}, delta / maximum),
+        hsv[index::saturation] + offset);
 
-    GetValue(hsv) = extrema.planes[1];
+    StoreHsvBlock<F, I>(maximum, hsv[index::value] + offset);
 
     if constexpr (count == 4)
     {
-        GetAlpha(hsv) = GetAlpha(rgbFloat);
+        StoreHsvBlock<F, I>(
+            LoadHsvBlock<F>(rgb[index::alpha] + offset, pixelCount),
+            hsv[index::alpha] + offset);
     }
+}
 
-    if constexpr (std::is_integral_v<I>)
+
+} // end namespace detail
+
+
+/**
+ ** Converts in a single pass over the planes, reading each input sample once
+ ** and writing each output sample once.
+ **
+ ** rgb and hsv may each be a Planar or a PlanarView, and must have the same
+ ** size and storage order.
+ **/
+template
+<
+    typename Rgb,
+    typename Hsv,
+    typename = std::enable_if_t<IsPlanar<Rgb> && IsPlanar<Hsv>>
+>
+void RgbToHsv(const Rgb &rgb, Hsv &hsv)
+{
+    using F = typename Hsv::Type;
+    using I = typename Rgb::Type;
+    static constexpr auto count = Rgb::count;
+
+    static_assert(std::is_floating_point_v<F>);
+    static_assert(count == 3 || count == 4);
+    static_assert(Hsv::count == count);
+    static_assert(Hsv::options == Rgb::options);
+
+    using Index = Eigen::Index;
+
+    if (
+        hsv.GetRowCount() != rgb.GetRowCount()
+        || hsv.GetColumnCount() != rgb.GetColumnCount())
     {
-        if constexpr (sizeof(I) == 1)
-        {
-            // Round to 3 decimals.
-            hsv.template Round<3>();
-        }
-        else if constexpr (sizeof(I) == 2)
-        {
-            // Round to 6 decimals
-            hsv.template Round<6>();
-        }
+        throw PlanarError("RgbToHsv requires planes of the same size");
+    }
+
+    // Every plane has the same size and storage order, so a pixel has the
+    // same offset in each.
+    std::array<const I *, count> source;
+    std::array<F *, count> target;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        source[i] = rgb.planes[i].data();
+        target[i] = hsv.planes[i].data();
     }
 
+    Index pixelCount = rgb.planes[0].size();
+
+    for (Index offset = 0; offset < pixelCount; offset += detail::hsvBlockSize)
+    {
+        detail::RgbToHsvBlock<F, I, count>(
+            source,
+            target,
+            offset,
+            std::min(detail::hsvBlockSize, pixelCount - offset));
+    }
+}
+
+
+template
+<
+    typename F,
+    size_t count,
+    typename I,
+    int rows,
+    int columns,
+    int options
+>
+auto RgbToHsv(const Planar<count, I, rows, columns, options> &rgb)
+{
+    Planar<count, F, rows, columns, options> hsv(
+        rgb.GetRowCount(),
+        rgb.GetColumnCount());
+
+    RgbToHsv(rgb, hsv);
+
+    return hsv;
+}
+
+
+template<typename F, size_t count, typename I, int options>
+auto RgbToHsv(const PlanarView<count, I, options> &rgb)
+{
+    Planar<count, F, Eigen::Dynamic, Eigen::Dynamic, options> hsv(
+        rgb.GetRowCount(),
+        rgb.GetColumnCount());
+
+    RgbToHsv(rgb, hsv);
+
     return hsv;
 }
 
@@ -1024,4 +1239,281 @@ using RgbPlanes =
     tau::Planar<3, T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 
 
+/**
+ ** Table-driven conversions between 8-bit RGB and HSV.
+ **
+ ** RgbToHsv reads value, saturation, and hue from tables indexed by the
+ ** largest channel and the channel differences, without division or fmod.
+ ** RgbToHsv rounds 8-bit input to 3 decimals, and each component here is
+ ** within one in the third decimal of it.
+ **
+ ** HsvToRgb quantizes hue to 1/256 of each 60 degree sector, and reads the
+ ** weight of each channel from a table, without fmod or a switch. Each
+ ** channel is within one count of HsvToRgb<uint8_t>. Hue is clamped to
+ ** [0, 360], and saturation and value to [0, 1]. NaN is taken as 0.
+ **
+ ** Alpha is scaled as the other conversions scale it.
+ **
+ ** The tables are built by the first call to Get, once per process.
+ **/
+class HsvLookup
+{
+public:
+    static const HsvLookup & Get();
+
+    template<typename F>
+    void RgbToHsv(
+        uint8_t red,
+        uint8_t green,
+        uint8_t blue,
+        F &hue,
+        F &saturation,
+        F &value) const
+    {
+        static_assert(std::is_floating_point_v<F>);
+
+        // Ties go to the first maximum, as they do in RgbToHsv.
+        // Selects instead of branches keep random colors from stalling.
+        bool isGreen = (green > red) && (green >= blue);
+        bool isBlue = !isGreen && (blue > red);
+
+        int maximum = std::max(red, std::max(green, blue));
+        int minimum = std::min(red, std::min(green, blue));
+
+        int difference = isGreen
+            ? blue - red
+            : (isBlue ? red - green : green - blue);
+
+        int base = isGreen ? 120000 : (isBlue ? 240000 : 0);
+
+        auto delta = static_cast<size_t>(maximum - minimum);
+        auto row = static_cast<size_t>(maximum) * tableSize;
+
+        int offset = this->hue_[
+            delta * tableSize + static_cast<size_t>(std::abs(difference))];
+
+        // Only red can wrap below zero degrees.
+        int thousandths = (difference < 0)
+            ? ((base == 0) ? 360000 : base) - offset
+            : base + offset;
+
+        hue = static_cast<F>(thousandths) / F{1000};
+
+        saturation =
+            static_cast<F>(this->saturation_[row + delta]) / F{1000};
+
+        value = static_cast<F>(this->value_[static_cast<size_t>(maximum)])
+            / F{1000};
+    }
+
+    template<typename F>
+    F ScaleAlpha(uint8_t alpha) const
+    {
+        return static_cast<F>(this->value_[alpha]) / F{1000};
+    }
+
+    template<typename F>
+    void HsvToRgb(
+        F hue,
+        F saturation,
+        F value,
+        uint8_t &red,
+        uint8_t &green,
+        uint8_t &blue) const
+    {
+        static_assert(std::is_floating_point_v<F>);
+
+        static constexpr auto stepsPerDegree =
+            static_cast<F>(sectorSteps) / F{60};
+
+        auto step = static_cast<Eigen::Index>(
+            std::round(Clamp_(hue, F{360}) * stepsPerDegree));
+
+        const auto &weights = this->weights_[static_cast<size_t>(step)];
+
+        // Each channel is m + C * weight, scaled to 255, and rounded by
+        // truncating after adding one half.
+        static constexpr auto half = F{0.5};
+        auto scaledValue = Clamp_(value, F{1}) * F{255};
+        auto chroma = scaledValue * Clamp_(saturation, F{1});
+        auto minimum = scaledValue - chroma;
+
+        red = static_cast<uint8_t>(
+            minimum + chroma * static_cast<F>(weights[index::red]) + half);
+
+        green = static_cast<uint8_t>(
+            minimum + chroma * static_cast<F>(weights[index::green]) + half);
+
+        blue = static_cast<uint8_t>(
+            minimum + chroma * static_cast<F>(weights[index::blue]) + half);
+    }
+
+    template<typename F>
+    uint8_t UnscaleAlpha(F alpha) const
+    {
+        return static_cast<uint8_t>(std::lround(alpha * F{255}));
+    }
+
+    template<typename F>
+    ColorVector<F> RgbToHsv(const ColorVector<uint8_t> &rgb) const
+    {
+        ColorVector<F> hsv;
+
+        this->RgbToHsv(
+            rgb(index::red),
+            rgb(index::green),
+            rgb(index::blue),
+            hsv(index::hue),
+            hsv(index::saturation),
+            hsv(index::value));
+
+        return hsv;
+    }
+
+    template<typename F>
+    ColorVector<uint8_t> HsvToRgb(const ColorVector<F> &hsv) const
+    {
+        ColorVector<uint8_t> rgb;
+
+        this->HsvToRgb(
+            hsv(index::hue),
+            hsv(index::saturation),
+            hsv(index::value),
+            rgb(index::red),
+            rgb(index::green),
+            rgb(index::blue));
+
+        return rgb;
+    }
+
+    template
+    <
+        typename F,
+        size_t count,
+        int rows,
+        int columns,
+        int options
+    >
+    Planar<count, F, rows, columns, options> RgbToHsv(
+        const Planar<count, uint8_t, rows, columns, options> &rgb) const
+    {
+        static_assert(count == 3 || count == 4);
+
+        Planar<count, F, rows, columns, options> hsv(
+            rgb.GetRowCount(),
+            rgb.GetColumnCount());
+
+        const uint8_t *red = GetRed(rgb).data();
+        const uint8_t *green = GetGreen(rgb).data();
+        const uint8_t *blue = GetBlue(rgb).data();
+        F *hue = GetHue(hsv).data();
+        F *saturation = GetSaturation(hsv).data();
+        F *value = GetValue(hsv).data();
+
+        Eigen::Index pixelCount = GetRed(rgb).size();
+
+        for (Eigen::Index i = 0; i < pixelCount; ++i)
+        {
+            this->RgbToHsv(
+                red[i],
+                green[i],
+                blue[i],
+                hue[i],
+                saturation[i],
+                value[i]);
+        }
+
+        if constexpr (count == 4)
+        {
+            const uint8_t *alpha = GetAlpha(rgb).data();
+            F *scaled = GetAlpha(hsv).data();
+
+            for (Eigen::Index i = 0; i < pixelCount; ++i)
+            {
+                scaled[i] = this->ScaleAlpha<F>(alpha[i]);
+            }
+        }
+
+        return hsv;
+    }
+
+    template
+    <
+        typename F,
+        size_t count,
+        int rows,
+        int columns,
+        int options
+    >
+    Planar<count, uint8_t, rows, columns, options> HsvToRgb(
+        const Planar<count, F, rows, columns, options> &hsv) const
+    {
+        static_assert(count == 3 || count == 4);
+
+        Planar<count, uint8_t, rows, columns, options> rgb(
+            hsv.GetRowCount(),
+            hsv.GetColumnCount());
+
+        const F *hue = GetHue(hsv).data();
+        const F *saturation = GetSaturation(hsv).data();
+        const F *value = GetValue(hsv).data();
+        uint8_t *red = GetRed(rgb).data();
+        uint8_t *green = GetGreen(rgb).data();
+        uint8_t *blue = GetBlue(rgb).data();
+
+        Eigen::Index pixelCount = GetHue(hsv).size();
+
+        for (Eigen::Index i = 0; i < pixelCount; ++i)
+        {
+            this->HsvToRgb(
+                hue[i],
+                saturation[i],
+                value[i],
+                red[i],
+                green[i],
+                blue[i]);
+        }
+
+        if constexpr (count == 4)
+        {
+            const F *alpha = GetAlpha(hsv).data();
+            uint8_t *unscaled = GetAlpha(rgb).data();
+
+            for (Eigen::Index i = 0; i < pixelCount; ++i)
+            {
+                unscaled[i] = this->UnscaleAlpha(alpha[i]);
+            }
+        }
+
+        return rgb;
+    }
+
+private:
+    HsvLookup();
+
+    // Clamps to [0, high], where std::clamp would pass NaN through.
+    template<typename F>
+    static F Clamp_(F x, F high)
+    {
+        return (x > F{0}) ? std::min(x, high) : F{0};
+    }
+
+    static constexpr size_t tableSize = 256;
+    static constexpr size_t sectorSteps = 256;
+
+    // Indexed by maximum, in thousandths.
+    std::vector<uint16_t> value_;
+
+    // Indexed by maximum * tableSize + delta, in thousandths.
+    std::vector<uint16_t> saturation_;
+
+    // 60 * difference / delta in thousandths of a degree, indexed by
+    // delta * tableSize + |difference|.
+    std::vector<uint16_t> hue_;
+
+    // The weight of each channel at each hue step.
+    std::vector<std::array<float, 3>> weights_;
+};
+
+
 } // end namespace tau
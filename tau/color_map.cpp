@@ -5,7 +5,136 @@ namespace tau
 {
 
 
+PaletteCache::PaletteCache(size_t capacity)
+    :
+    capacity_(capacity),
+    masterFlags_(),
+    masters_(),
+    mutex_(),
+    entries_(),
+    index_()
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("capacity must be at least 1");
+    }
+}
+
+
+PaletteCache & PaletteCache::Get()
+{
+    static PaletteCache paletteCache;
+
+    return paletteCache;
+}
+
+
+const PaletteCache::Palette & PaletteCache::GetMaster_(bool turbo)
+{
+    auto index = static_cast<size_t>(turbo);
+
+    std::call_once(
+        this->masterFlags_[index],
+        [this, turbo, index]()
+        {
+            this->masters_[index] = turbo
+                ? turbo::MakeRgb8(masterCount)
+                : gray::MakeRgb8(masterCount);
+        });
+
+    return this->masters_[index];
+}
+
+
+std::shared_ptr<const PaletteCache::Palette> PaletteCache::GetPalette(
+    bool turbo,
+    size_t count)
+{
+    if (count < 2)
+    {
+        throw std::invalid_argument("count must be at least 2");
+    }
+
+    Key key{turbo, count};
+
+    {
+        std::lock_guard lock(this->mutex_);
+        auto found = this->index_.find(key);
+
+        if (found != this->index_.end())
+        {
+            this->entries_.splice(
+                this->entries_.begin(),
+                this->entries_,
+                found->second);
+
+            return found->second->second;
+        }
+    }
+
+    // Copy without holding the lock, so other palettes can be found
+    // meanwhile.
+    const auto &master = this->GetMaster_(turbo);
+    auto sampled =
+        std::make_shared<Palette>(static_cast<Eigen::Index>(count), 3);
+
+    const uint64_t last = count - 1;
+    const uint64_t masterLast = masterCount - 1;
+
+    for (uint64_t i = 0; i <= last; ++i)
+    {
+        // Rounds to the nearest color of the master.
+        auto row = (2 * i * masterLast + last) / (2 * last);
+
+        sampled->row(static_cast<Eigen::Index>(i)) =
+            master.row(static_cast<Eigen::Index>(row));
+    }
+
+    std::shared_ptr<const Palette> palette = std::move(sampled);
+
+    std::lock_guard lock(this->mutex_);
+    auto found = this->index_.find(key);
+
+    if (found != this->index_.end())
+    {
+        // Another thread generated it first.
+        return found->second->second;
+    }
+
+    this->entries_.emplace_front(key, palette);
+    this->index_[key] = this->entries_.begin();
+
+    if (this->entries_.size() > this->capacity_)
+    {
+        this->index_.erase(this->entries_.back().first);
+        this->entries_.pop_back();
+    }
+
+    return palette;
+}
+
+
+size_t PaletteCache::GetSize() const
+{
+    std::lock_guard lock(this->mutex_);
+
+    return this->entries_.size();
+}
+
+
+AutoRangeSettings AutoRangeSettings::Default()
+{
+    return {0.01, 0.99, 0.0, 0.05, 4096};
+}
+
+
 template class ColorMap<int32_t>;
+template class AutoRangeColorMap<int32_t>;
+template class QuantizedColorMap<float>;
+template class QuantizedColorMap<double>;
+template class DivergingColorMap<int16_t>;
+template class DivergingColorMap<int32_t>;
+template class DivergingColorMap<float>;
 
 
 } // end namespace tau
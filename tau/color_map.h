@@ -11,12 +11,24 @@
 
 #pragma once
 
+#include <array>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include <tau/eigen.h>
 #include <tau/color_maps/rgb.h>
 #include <tau/color_maps/turbo.h>
 #include <tau/color_maps/gray.h>
+#include <tau/color_maps/diverging.h>
 #include <tau/mono_image.h>
 #include <tau/color_map_settings.h>
+#include <tau/frame_pool.h>
+#include <tau/histogram.h>
+#include <tau/row_bands.h>
 
 
 namespace tau
@@ -37,11 +49,22 @@ public:
 
     BasicColorMap(const Colors &map)
         :
-        map_(map)
+        map_(std::make_shared<const Colors>(map))
     {
 
     }
 
+    // Shares colors with every other map created from them.
+    BasicColorMap(const std::shared_ptr<const Colors> &map)
+        :
+        map_(map)
+    {
+        if (!map)
+        {
+            throw std::invalid_argument("map must not be null");
+        }
+    }
+
     template<typename Input, typename Output>
     void operator()(
         const Eigen::MatrixBase<Input> &input,
@@ -53,15 +76,20 @@ public:
             std::is_integral_v<typename InputTraits::type>,
             "Input must be integral");
 
-        *output = this->map_(
+        *output = this->GetColors()(
             input.template reshaped<Eigen::AutoOrder>(),
             Eigen::all).eval();
 
         assert(output->rows() == input.size());
     }
 
+    const Colors & GetColors() const
+    {
+        return *this->map_;
+    }
+
 protected:
-    Colors map_;
+    std::shared_ptr<const Colors> map_;
 };
 
 
@@ -116,6 +144,117 @@ private:
 };
 
 
+/**
+ ** Rescales integral values to indices in fixed point, with the same
+ ** rounding as FloatRescale applied to exact arithmetic.
+ **
+ ** The rounded index is floor(numerator / divisor), with
+ ** numerator = 2 * offset * (count - 1) + range and divisor = 2 * range.
+ ** While numerators stay below 2^31, the division is replaced by a multiply
+ ** and a shift that are exact for every numerator in range.
+ **/
+template<typename Bound>
+class FixedRescale
+{
+public:
+    // Wider bounds could overflow the 64-bit intermediates.
+    static_assert(std::is_integral_v<Bound> && sizeof(Bound) <= 4);
+
+    FixedRescale(Eigen::Index count, Bound minimum, Bound maximum)
+        :
+        minimum_(minimum),
+        maximum_(maximum),
+        scale_(),
+        range_(),
+        multiplier_(0),
+        shift_(0),
+        isFast_(false)
+    {
+        assert(count > 0);
+        assert(minimum < maximum);
+
+        this->scale_ = 2 * static_cast<uint64_t>(count - 1);
+
+        this->range_ = static_cast<uint64_t>(
+            static_cast<int64_t>(maximum) - static_cast<int64_t>(minimum));
+
+        static constexpr uint64_t numeratorLimit = uint64_t{1} << 31;
+
+        // Whether range * scale + range < numeratorLimit, without
+        // overflowing.
+        bool fitsLimit = this->range_ < numeratorLimit
+            && this->scale_
+                <= (numeratorLimit - this->range_ - 1) / this->range_;
+
+        if (!fitsLimit)
+        {
+            return;
+        }
+
+        auto divisor = 2 * this->range_;
+        unsigned divisorBits = 0;
+
+        while ((uint64_t{1} << divisorBits) < divisor)
+        {
+            ++divisorBits;
+        }
+
+        this->shift_ = 31 + divisorBits;
+
+        // ceil(2^shift / divisor)
+        this->multiplier_ =
+            ((uint64_t{1} << this->shift_) + divisor - 1) / divisor;
+
+        this->isFast_ = true;
+    }
+
+    template<typename Value>
+    Eigen::Index GetIndex(Value value) const
+    {
+        static_assert(std::is_integral_v<Value>);
+
+        // Compared before any cast, so 64-bit values cannot wrap.
+        uint64_t offset = 0;
+
+        if (std::cmp_greater_equal(value, this->maximum_))
+        {
+            offset = this->range_;
+        }
+        else if (std::cmp_greater(value, this->minimum_))
+        {
+            offset = static_cast<uint64_t>(
+                static_cast<int64_t>(value)
+                - static_cast<int64_t>(this->minimum_));
+        }
+
+        auto numerator = offset * this->scale_ + this->range_;
+
+        if (this->isFast_)
+        {
+            return static_cast<Eigen::Index>(
+                (numerator * this->multiplier_) >> this->shift_);
+        }
+
+        return static_cast<Eigen::Index>(numerator / (2 * this->range_));
+    }
+
+    // Whether GetIndex uses the multiply and shift.
+    bool IsFast() const
+    {
+        return this->isFast_;
+    }
+
+private:
+    Bound minimum_;
+    Bound maximum_;
+    uint64_t scale_;
+    uint64_t range_;
+    uint64_t multiplier_;
+    unsigned shift_;
+    bool isFast_;
+};
+
+
 template<typename Bound>
 class Rescale
 {
@@ -136,7 +275,62 @@ public:
         return input;
     }
 
+    // Values are compared with the bounds before any cast, because Value may
+    // not hold them. NaN maps to the first index.
+    template<typename Value>
+    Eigen::Index GetIndex(Value value) const
+    {
+        if constexpr (std::is_integral_v<Value> && std::is_integral_v<Bound>)
+        {
+            if (std::cmp_less_equal(value, this->minimum_))
+            {
+                return 0;
+            }
+
+            if (std::cmp_greater_equal(value, this->maximum_))
+            {
+                return this->GetOffset_(this->maximum_);
+            }
+
+            return this->GetOffset_(value);
+        }
+        else
+        {
+            auto minimum = static_cast<double>(this->minimum_);
+            auto clamped = std::min(
+                static_cast<double>(value),
+                static_cast<double>(this->maximum_));
+
+            if (!(clamped > minimum))
+            {
+                return 0;
+            }
+
+            return static_cast<Eigen::Index>(clamped - minimum);
+        }
+    }
+
+    Bound GetMinimum() const
+    {
+        return this->minimum_;
+    }
+
+    Bound GetMaximum() const
+    {
+        return this->maximum_;
+    }
+
 private:
+    // The difference wraps in uint64_t, which is exact for any value in
+    // [minimum, maximum] of a range that fits an Index.
+    template<typename Value>
+    Eigen::Index GetOffset_(Value value) const
+    {
+        return static_cast<Eigen::Index>(
+            static_cast<uint64_t>(value)
+            - static_cast<uint64_t>(this->minimum_));
+    }
+
     Bound minimum_;
     Bound maximum_;
 };
@@ -146,6 +340,16 @@ template<typename Input>
 using IndexMatrix = MatrixLike<Eigen::Index, Input>;
 
 
+/**
+ ** Scales values from [minimum, maximum] to the rows of the color map.
+ **
+ ** With integral bounds of 32 bits or fewer, integral values are mapped in
+ ** one pass, with no temporaries. When Bound has 16 bits or fewer, the color
+ ** of every value of Bound is looked up when the map is created, and inputs
+ ** of type Bound read it directly. Other integral inputs are rescaled with
+ ** FixedRescale, and everything else, including 64-bit bounds, with
+ ** FloatRescale.
+ **/
 template<
     typename ColorType,
     typename Bound,
@@ -154,13 +358,47 @@ class ScaledColorMap: public BasicColorMap<ColorType>
 {
 public:
     using Base = BasicColorMap<ColorType>;
+    using ColorsTraits = typename Base::ColorsTraits;
+
+    using ColorTable = Eigen::Matrix
+    <
+        typename ColorsTraits::type,
+        Eigen::Dynamic,
+        ColorsTraits::columns,
+        Eigen::RowMajor
+    >;
+
+    static constexpr bool hasFixedRescale =
+        std::is_integral_v<Bound> && sizeof(Bound) <= 4;
+
+    static constexpr bool hasColorTable =
+        std::is_integral_v<Bound> && sizeof(Bound) <= 2;
 
     ScaledColorMap(const ColorType &map, Bound minimum, Bound maximum)
         :
         Base(map),
-        rescale_(this->map_.rows(), minimum, maximum)
+        rescale_(this->GetColors().rows(), minimum, maximum),
+        fixedRescale_(
+            MakeFixedRescale_(this->GetColors().rows(), minimum, maximum)),
+        colorTable_()
     {
+        if constexpr (hasColorTable)
+        {
+            static constexpr auto lowest =
+                static_cast<Eigen::Index>(std::numeric_limits<Bound>::lowest());
+
+            static constexpr auto highest =
+                static_cast<Eigen::Index>(std::numeric_limits<Bound>::max());
 
+            const auto &colors = this->GetColors();
+            this->colorTable_.resize(highest - lowest + 1, colors.cols());
+
+            for (Eigen::Index value = lowest; value <= highest; ++value)
+            {
+                this->colorTable_.row(value - lowest) = colors.row(
+                    this->fixedRescale_.GetIndex(static_cast<Bound>(value)));
+            }
+        }
     }
 
     template<typename Input, typename Output>
@@ -168,17 +406,68 @@ public:
         const Eigen::MatrixBase<Input> &input,
         Eigen::MatrixBase<Output> *output) const
     {
-        Input rescaled = input;
+        using Value = typename Input::Scalar;
 
-        *output = this->map_(
-            this->rescale_(rescaled).template reshaped<Eigen::AutoOrder>(),
-            Eigen::all).eval();
+        if constexpr (std::is_integral_v<Value> && hasFixedRescale)
+        {
+            const auto &colors = this->GetColors();
+            auto values = input.template reshaped<Eigen::AutoOrder>();
+            output->derived().resize(input.size(), colors.cols());
+
+            if constexpr (hasColorTable && std::is_same_v<Value, Bound>)
+            {
+                static constexpr auto lowest = static_cast<Eigen::Index>(
+                    std::numeric_limits<Bound>::lowest());
+
+                for (Eigen::Index i = 0; i < values.size(); ++i)
+                {
+                    output->row(i) = this->colorTable_.row(
+                        static_cast<Eigen::Index>(values(i)) - lowest);
+                }
+            }
+            else
+            {
+                for (Eigen::Index i = 0; i < values.size(); ++i)
+                {
+                    output->row(i) = colors.row(
+                        this->fixedRescale_.GetIndex(values(i)));
+                }
+            }
+        }
+        else
+        {
+            typename Input::PlainObject rescaled = input;
+
+            *output = this->GetColors()(
+                this->rescale_(rescaled).template reshaped<Eigen::AutoOrder>(),
+                Eigen::all).eval();
+        }
 
         assert(output->rows() == input.size());
     }
 
 private:
+    using FixedBound = std::conditional_t<hasFixedRescale, Bound, int32_t>;
+
+    static FixedRescale<FixedBound> MakeFixedRescale_(
+        Eigen::Index count,
+        Bound minimum,
+        Bound maximum)
+    {
+        if constexpr (hasFixedRescale)
+        {
+            return {count, minimum, maximum};
+        }
+        else
+        {
+            // Unused. Inputs are rescaled with FloatRescale.
+            return {count, 0, 1};
+        }
+    }
+
     FloatRescale<Bound, Float> rescale_;
+    FixedRescale<FixedBound> fixedRescale_;
+    ColorTable colorTable_;
 };
 
 
@@ -193,29 +482,345 @@ public:
         Base(map),
         rescale_(minimum, maximum)
     {
-        if ((maximum - minimum + 1) != map.rows())
+        this->CheckSize_();
+    }
+
+    LimitedColorMap(
+        const std::shared_ptr<const ColorType> &map,
+        Bound minimum,
+        Bound maximum)
+        :
+        Base(map),
+        rescale_(minimum, maximum)
+    {
+        this->CheckSize_();
+    }
+
+    /**
+     ** Reads input in place, so it may be an Eigen::Map of a caller's
+     ** buffer. output is resized if it is a plain matrix, and must already
+     ** have one row for each input value if it is a Map.
+     **/
+    template<typename Input, typename Output>
+    void operator()(
+        const Eigen::MatrixBase<Input> &input,
+        Eigen::MatrixBase<Output> *output) const
+    {
+        const auto &colors = this->GetColors();
+        auto values = input.template reshaped<Eigen::AutoOrder>();
+        output->derived().resize(input.size(), colors.cols());
+
+        for (Eigen::Index i = 0; i < values.size(); ++i)
+        {
+            output->row(i) = colors.row(this->rescale_.GetIndex(values(i)));
+        }
+    }
+
+    Bound GetMinimum() const
+    {
+        return this->rescale_.GetMinimum();
+    }
+
+    Bound GetMaximum() const
+    {
+        return this->rescale_.GetMaximum();
+    }
+
+private:
+    void CheckSize_() const
+    {
+        auto minimum = this->rescale_.GetMinimum();
+        auto maximum = this->rescale_.GetMaximum();
+
+        if ((maximum - minimum + 1) != this->GetColors().rows())
         {
             throw std::invalid_argument(
                 "color map must match the size of the range.");
         }
     }
 
+    Rescale<Bound> rescale_;
+};
+
+
+namespace detail
+{
+
+
+// Red in the first byte in memory, and an opaque alpha.
+template<typename Colors>
+uint32_t PackRgba(const Colors &colors, Eigen::Index index)
+{
+    std::array<uint8_t, 4> bytes{
+        colors(index, 0),
+        colors(index, 1),
+        colors(index, 2),
+        std::numeric_limits<uint8_t>::max()};
+
+    uint32_t result;
+    std::memcpy(&result, bytes.data(), sizeof(result));
+
+    return result;
+}
+
+
+// Packed maps read and write contiguous memory in one linear pass.
+template<typename Input, typename Output>
+void RequirePackedOutput(
+    const Eigen::MatrixBase<Input> &input,
+    const Eigen::MatrixBase<Output> &output)
+{
+    static_assert(std::is_same_v<typename Output::Scalar, uint32_t>);
+
+    static_assert(
+        bool(Input::IsRowMajor) == bool(Output::IsRowMajor),
+        "input and output must share a storage order");
+
+    if (output.rows() != input.rows() || output.cols() != input.cols())
+    {
+        throw std::invalid_argument("output must match the size of input");
+    }
+
+    if (
+        input.innerStride() != 1
+        || output.innerStride() != 1
+        || input.outerStride() != input.innerSize()
+        || output.outerStride() != output.innerSize())
+    {
+        throw std::invalid_argument("input and output must be contiguous");
+    }
+}
+
+
+} // end namespace detail
+
+
+/**
+ ** Maps values to packed RGBA words, with red in the first byte in memory
+ ** and an opaque alpha, as display surfaces expect.
+ **
+ ** The colors are packed once when the map is created. Values of 16 bits or
+ ** fewer index a table that covers every value of the type, so each pixel
+ ** is one read, one table load and one write, with no clamping. Wider values
+ ** are clamped to the range of the table first.
+ **/
+template<typename Value>
+class PackedColorMap
+{
+public:
+    static_assert(std::is_integral_v<Value>, "Value must be integral");
+
+    using Index = Eigen::Index;
+    using Word = uint32_t;
+
+    static constexpr bool coversType = sizeof(Value) <= 2;
+
+    // colors has one row of 8-bit red, green and blue for each value from
+    // minimum to maximum.
+    template<typename Colors>
+    PackedColorMap(const Colors &colors, Value minimum, Value maximum)
+        :
+        minimum_(minimum),
+        maximum_(maximum),
+        offset_(),
+        table_()
+    {
+        static_assert(
+            std::is_same_v<typename Colors::Scalar, uint8_t>,
+            "Expected 8-bit colors");
+
+        if (
+            minimum > maximum
+            || static_cast<Index>(maximum) - static_cast<Index>(minimum) + 1
+                != colors.rows())
+        {
+            throw std::invalid_argument(
+                "color map must match the size of the range.");
+        }
+
+        if constexpr (coversType)
+        {
+            static constexpr auto lowest =
+                static_cast<Index>(std::numeric_limits<Value>::lowest());
+
+            static constexpr auto highest =
+                static_cast<Index>(std::numeric_limits<Value>::max());
+
+            this->offset_ = lowest;
+            this->table_.resize(static_cast<size_t>(highest - lowest + 1));
+
+            for (Index value = lowest; value <= highest; ++value)
+            {
+                auto index = std::clamp(
+                    value,
+                    static_cast<Index>(minimum),
+                    static_cast<Index>(maximum)) - minimum;
+
+                this->table_[static_cast<size_t>(value - lowest)] =
+                    detail::PackRgba(colors, index);
+            }
+        }
+        else
+        {
+            this->offset_ = static_cast<Index>(minimum);
+            this->table_.resize(static_cast<size_t>(colors.rows()));
+
+            for (Index index = 0; index < colors.rows(); ++index)
+            {
+                this->table_[static_cast<size_t>(index)] =
+                    detail::PackRgba(colors, index);
+            }
+        }
+    }
+
+    template<typename ColorType>
+    explicit PackedColorMap(const LimitedColorMap<ColorType, Value> &colorMap)
+        :
+        PackedColorMap(
+            colorMap.GetColors(),
+            colorMap.GetMinimum(),
+            colorMap.GetMaximum())
+    {
+
+    }
+
+    // output must hold count words.
+    void operator()(const Value *input, Word *output, Index count) const
+    {
+        const Word *table = this->table_.data();
+        const Index offset = this->offset_;
+
+        if constexpr (coversType)
+        {
+            for (Index i = 0; i < count; ++i)
+            {
+                output[i] = table[static_cast<Index>(input[i]) - offset];
+            }
+        }
+        else
+        {
+            const Value minimum = this->minimum_;
+            const Value maximum = this->maximum_;
+
+            for (Index i = 0; i < count; ++i)
+            {
+                output[i] = table[
+                    static_cast<Index>(std::clamp(input[i], minimum, maximum))
+                    - offset];
+            }
+        }
+    }
+
+    /**
+     ** input and output must be contiguous, with the same size and storage
+     ** order, like a MonoImage<Value> and a MonoImage<uint32_t>. Either may
+     ** be an Eigen::Map of a caller's buffer.
+     **/
     template<typename Input, typename Output>
     void operator()(
         const Eigen::MatrixBase<Input> &input,
         Eigen::MatrixBase<Output> *output) const
     {
-        Input rescaled = input;
+        static_assert(std::is_same_v<typename Input::Scalar, Value>);
+        detail::RequirePackedOutput(input, *output);
 
-        *output = this->map_(
-            this->rescale_(rescaled).template reshaped<Eigen::AutoOrder>(),
-            Eigen::all).eval();
+        (*this)(input.derived().data(), output->derived().data(), input.size());
+    }
 
-        assert(output->rows() == input.size());
+private:
+    Value minimum_;
+    Value maximum_;
+    Index offset_;
+    std::vector<Word> table_;
+};
+
+
+/**
+ ** Maps row bands of a row-major input in parallel, with a ScaledColorMap
+ ** or LimitedColorMap. output has one row of color for each input value,
+ ** and must already have its final size. Each band writes only its own
+ ** rows of output.
+ **/
+template<typename ColorMapType, typename Input, typename Output>
+void MapRowBands(
+    const ColorMapType &colorMap,
+    const Eigen::MatrixBase<Input> &input,
+    Eigen::MatrixBase<Output> *output,
+    ThreadPool &threadPool)
+{
+    static_assert(
+        bool(Input::IsRowMajor) || Input::ColsAtCompileTime == 1,
+        "Bands of rows must be contiguous in the input");
+
+    if (output->rows() != input.size())
+    {
+        throw std::invalid_argument("output must have a row for each value");
     }
 
+    auto columnCount = input.cols();
+
+    ForEachRowBand(
+        input.rows(),
+        threadPool,
+        [&](Eigen::Index firstRow, Eigen::Index rowCount)
+        {
+            auto target = output->middleRows(
+                firstRow * columnCount,
+                rowCount * columnCount);
+
+            colorMap(input.middleRows(firstRow, rowCount), &target);
+        });
+}
+
+
+/**
+ ** Keeps the 8-bit palettes most recently used by ColorMap, keyed by the
+ ** kind of map and the number of colors.
+ **
+ ** Each kind of map is evaluated once, into a master palette of
+ ** masterCount colors. A palette of any other count takes the nearest
+ ** color of the master for each of its own, so a new range copies colors
+ ** without evaluating the map again, and a range seen recently is shared.
+ ** Safe to use from any thread.
+ **/
+class PaletteCache
+{
+public:
+    using Palette = RgbMatrix<uint8_t>;
+
+    static constexpr size_t defaultCapacity = 64;
+
+    // A color for every 16-bit value. The count of colors in 8-bit and
+    // 16-bit ranges divides it evenly, so their palettes are exact.
+    static constexpr size_t masterCount = 65536;
+
+    explicit PaletteCache(size_t capacity = defaultCapacity);
+
+    // The cache shared by every ColorMap in the process.
+    static PaletteCache & Get();
+
+    // count must be at least 2.
+    std::shared_ptr<const Palette> GetPalette(bool turbo, size_t count);
+
+    size_t GetSize() const;
+
 private:
-    Rescale<Bound> rescale_;
+    using Key = std::pair<bool, size_t>;
+    using Entry = std::pair<Key, std::shared_ptr<const Palette>>;
+
+    const Palette & GetMaster_(bool turbo);
+
+    size_t capacity_;
+
+    // Indexed by turbo, and evaluated on first use.
+    std::once_flag masterFlags_[2];
+    Palette masters_[2];
+
+    mutable std::mutex mutex_;
+
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::map<Key, std::list<Entry>::iterator> index_;
 };
 
 
@@ -236,23 +841,21 @@ auto MakeColorMap(const ColorMapSettings<T> &colorMapSettings)
 
     size_t count = static_cast<size_t>(1 + high - low);
 
-    if (colorMapSettings.turbo)
-    {
-        return tau::LimitedColorMap<PixelMatrix, T>(
-            tau::turbo::MakeRgb8(count),
-            static_cast<T>(low),
-            static_cast<T>(high));
-    }
-    else
-    {
-        return tau::LimitedColorMap<PixelMatrix, T>(
-            tau::gray::MakeRgb8(count),
-            static_cast<T>(low),
-            static_cast<T>(high));
-    }
+    static_assert(std::is_same_v<PixelMatrix, PaletteCache::Palette>);
+
+    return tau::LimitedColorMap<PixelMatrix, T>(
+        PaletteCache::Get().GetPalette(colorMapSettings.turbo, count),
+        static_cast<T>(low),
+        static_cast<T>(high));
 }
 
 
+/**
+ ** Maps a MonoImage to RGB pixels.
+ **
+ ** A ColorMap is not modified after it is created, so one instance may be
+ ** shared by threads filtering separate frames at the same time.
+ **/
 template<typename Value>
 class ColorMap
 {
@@ -262,25 +865,691 @@ public:
 
     ColorMap(const ColorMapSettings<Value> &colorMapSettings)
         :
-        colorMap_(MakeColorMap<Pixels>(colorMapSettings))
+        colorMap_(MakeColorMap<Pixels>(colorMapSettings)),
+        packedColorMap_(this->colorMap_)
     {
 
     }
 
     Pixels Filter(const Matrix &data) const
     {
-        RgbPixels<uint8_t> result{{}, {data.cols(), data.rows()}};
+        Pixels result{
+            typename Pixels::Data(data.size(), 3),
+            {data.cols(), data.rows()}};
+
         this->colorMap_(data, &result.data);
 
         return result;
     }
 
+    /**
+     ** Writes into existing pixels without allocating. data may be an
+     ** Eigen::Map of a caller's buffer, and pixels may be Pixels or a
+     ** PixelsView, with the same size as data.
+     **/
+    template<typename Derived, typename Result>
+    void Filter(const Eigen::MatrixBase<Derived> &data, Result &pixels) const
+    {
+        if (
+            pixels.size.height != data.rows()
+            || pixels.size.width != data.cols())
+        {
+            throw std::invalid_argument("pixels must match the size of data");
+        }
+
+        this->colorMap_(data, &pixels.data);
+    }
+
+    // Writes into a frame recycled by pool, which must match the size of
+    // data.
+    template<typename Derived>
+    std::shared_ptr<Pixels> Filter(
+        const Eigen::MatrixBase<Derived> &data,
+        FramePool<Pixels> &pool) const
+    {
+        auto pixels = pool.Acquire();
+        this->Filter(data, *pixels);
+
+        return pixels;
+    }
+
+    /**
+     ** Writes packed RGBA words into packed, which must be contiguous with
+     ** the size and storage order of data, like a MonoImage<uint32_t>.
+     **/
+    template<typename Derived, typename Packed>
+    void FilterPacked(
+        const Eigen::MatrixBase<Derived> &data,
+        Eigen::MatrixBase<Packed> *packed) const
+    {
+        this->packedColorMap_(data, packed);
+    }
+
+    // Maps bands of rows on threadPool. pixels must match the size of data.
+    template<typename Derived, typename Result>
+    void Filter(
+        const Eigen::MatrixBase<Derived> &data,
+        Result &pixels,
+        ThreadPool &threadPool) const
+    {
+        if (
+            pixels.size.height != data.rows()
+            || pixels.size.width != data.cols())
+        {
+            throw std::invalid_argument("pixels must match the size of data");
+        }
+
+        MapRowBands(this->colorMap_, data, &pixels.data, threadPool);
+    }
+
+    Pixels Filter(const Matrix &data, ThreadPool &threadPool) const
+    {
+        Pixels result{
+            typename Pixels::Data(data.size(), 3),
+            {data.cols(), data.rows()}};
+
+        this->Filter(data, result, threadPool);
+
+        return result;
+    }
+
+    template<typename Derived, typename Packed>
+    void FilterPacked(
+        const Eigen::MatrixBase<Derived> &data,
+        Eigen::MatrixBase<Packed> *packed,
+        ThreadPool &threadPool) const
+    {
+        if (packed->rows() != data.rows() || packed->cols() != data.cols())
+        {
+            throw std::invalid_argument("output must match the size of input");
+        }
+
+        ForEachRowBand(
+            data.rows(),
+            threadPool,
+            [&](Eigen::Index firstRow, Eigen::Index rowCount)
+            {
+                auto target = packed->middleRows(firstRow, rowCount);
+
+                this->packedColorMap_(
+                    data.middleRows(firstRow, rowCount),
+                    &target);
+            });
+    }
+
 protected:
     LimitedColorMap<typename Pixels::Data, Value> colorMap_;
+    PackedColorMap<Value> packedColorMap_;
+};
+
+
+struct AutoRangeSettings
+{
+    // The percentiles of the histogram used as the low and high bounds.
+    double lowPercentile;
+    double highPercentile;
+
+    // The weight kept by earlier frames each time a frame is added.
+    double retention;
+
+    // The fraction of the current range that either bound must move before
+    // the color map is rebuilt.
+    double hysteresis;
+
+    size_t binCount;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&AutoRangeSettings::lowPercentile, "lowPercentile"),
+        fields::Field(&AutoRangeSettings::highPercentile, "highPercentile"),
+        fields::Field(&AutoRangeSettings::retention, "retention"),
+        fields::Field(&AutoRangeSettings::hysteresis, "hysteresis"),
+        fields::Field(&AutoRangeSettings::binCount, "binCount"));
+
+    static AutoRangeSettings Default();
+};
+
+
+/**
+ ** A ColorMap whose range follows percentiles of the incoming frames.
+ **
+ ** Each frame is counted in a StreamingHistogram spanning [minimum,
+ ** maximum], and the bounds are read from it without sorting. The ColorMap
+ ** is rebuilt only when a bound drifts further than the hysteresis, and is
+ ** shared as a pointer to const, so GetColorMap may be handed to other
+ ** threads. Update and Filter are not safe to call concurrently.
+ **/
+template<typename Value>
+class AutoRangeColorMap
+{
+public:
+    using Matrix = MonoImage<Value>;
+    using Pixels = RgbPixels<uint8_t>;
+    using Map = ColorMap<Value>;
+
+    AutoRangeColorMap(
+        const ColorMapSettings<Value> &colorMapSettings,
+        const AutoRangeSettings &autoRangeSettings,
+        Value minimum,
+        Value maximum)
+        :
+        colorMapSettings_(colorMapSettings),
+        autoRangeSettings_(autoRangeSettings),
+        histogram_(
+            minimum,
+            maximum,
+            autoRangeSettings.binCount,
+            autoRangeSettings.retention),
+        colorMap_(std::make_shared<const Map>(colorMapSettings)),
+        rebuildCount_(0)
+    {
+        if (
+            !(autoRangeSettings.lowPercentile
+                < autoRangeSettings.highPercentile))
+        {
+            throw std::invalid_argument(
+                "lowPercentile must be less than highPercentile");
+        }
+    }
+
+    // Counts frame, and rebuilds the map if the bounds have drifted.
+    template<typename Derived>
+    void Update(const Eigen::MatrixBase<Derived> &frame)
+    {
+        this->histogram_.AddFrame(frame);
+
+        auto low = this->histogram_.GetPercentile(
+            this->autoRangeSettings_.lowPercentile);
+
+        auto high = this->histogram_.GetPercentile(
+            this->autoRangeSettings_.highPercentile);
+
+        auto currentLow =
+            static_cast<double>(this->colorMapSettings_.range.low);
+
+        auto currentHigh =
+            static_cast<double>(this->colorMapSettings_.range.high);
+
+        double threshold = this->autoRangeSettings_.hysteresis
+            * std::max(currentHigh - currentLow, 1.0);
+
+        bool hasDrifted =
+            std::abs(static_cast<double>(low) - currentLow) > threshold
+            || std::abs(static_cast<double>(high) - currentHigh) > threshold;
+
+        if (!hasDrifted)
+        {
+            return;
+        }
+
+        this->colorMapSettings_.range.low = low;
+        this->colorMapSettings_.range.high = high;
+        this->colorMap_ = std::make_shared<const Map>(this->colorMapSettings_);
+        ++this->rebuildCount_;
+    }
+
+    Pixels Filter(const Matrix &frame)
+    {
+        this->Update(frame);
+
+        return this->colorMap_->Filter(frame);
+    }
+
+    // pixels may be Pixels or a PixelsView, with the same size as frame.
+    template<typename Derived, typename Result>
+    void Filter(const Eigen::MatrixBase<Derived> &frame, Result &pixels)
+    {
+        this->Update(frame);
+        this->colorMap_->Filter(frame, pixels);
+    }
+
+    std::shared_ptr<const Map> GetColorMap() const
+    {
+        return this->colorMap_;
+    }
+
+    const ColorMapSettings<Value> & GetColorMapSettings() const
+    {
+        return this->colorMapSettings_;
+    }
+
+    const StreamingHistogram<Value> & GetHistogram() const
+    {
+        return this->histogram_;
+    }
+
+    // The number of times the bounds have drifted far enough to rebuild.
+    size_t GetRebuildCount() const
+    {
+        return this->rebuildCount_;
+    }
+
+private:
+    ColorMapSettings<Value> colorMapSettings_;
+    AutoRangeSettings autoRangeSettings_;
+    StreamingHistogram<Value> histogram_;
+    std::shared_ptr<const Map> colorMap_;
+    size_t rebuildCount_;
+};
+
+
+/**
+ ** Maps floating-point or integral values of any range into a palette with
+ ** a fixed number of colors.
+ **
+ ** Each value is scaled to a palette index with one multiply and add, then
+ ** clamped, so memory does not grow with the range. Values below low, and
+ ** NaN, take the first color; values above high take the last.
+ **/
+template
+<
+    typename Value,
+    typename Float = std::conditional_t
+    <
+        std::is_same_v<Value, float> || sizeof(Value) <= 2,
+        float,
+        double
+    >
+>
+class QuantizedColorMap
+{
+public:
+    static_assert(std::is_arithmetic_v<Value>);
+    static_assert(std::is_floating_point_v<Float>);
+
+    using Matrix = MonoImage<Value>;
+    using Pixels = RgbPixels<uint8_t>;
+    using Palette = PaletteCache::Palette;
+
+    static constexpr size_t defaultCount = 4096;
+
+    QuantizedColorMap(
+        bool turbo,
+        Value low,
+        Value high,
+        size_t count = defaultCount)
+        :
+        palette_(),
+        scale_(),
+        offset_(),
+        last_()
+    {
+        if (!(low < high))
+        {
+            throw std::invalid_argument("low must be less than high");
+        }
+
+        if (count < 2)
+        {
+            throw std::invalid_argument("count must be at least 2");
+        }
+
+        this->palette_ = PaletteCache::Get().GetPalette(turbo, count);
+        this->last_ = static_cast<Float>(count - 1);
+
+        this->scale_ = this->last_
+            / (static_cast<Float>(high) - static_cast<Float>(low));
+
+        // Adding one half rounds to the nearest index when truncated.
+        this->offset_ =
+            Float(0.5) - static_cast<Float>(low) * this->scale_;
+    }
+
+    QuantizedColorMap(
+        const ColorMapSettings<Value> &colorMapSettings,
+        size_t count = defaultCount)
+        :
+        QuantizedColorMap(
+            colorMapSettings.turbo,
+            static_cast<Value>(colorMapSettings.range.low),
+            static_cast<Value>(colorMapSettings.range.high),
+            count)
+    {
+
+    }
+
+    Eigen::Index GetIndex(Value value) const
+    {
+        Float index =
+            static_cast<Float>(value) * this->scale_ + this->offset_;
+
+        // Written so that NaN compares false and selects zero.
+        index = (index >= Float(0))
+            ? ((index < this->last_) ? index : this->last_)
+            : Float(0);
+
+        return static_cast<Eigen::Index>(index);
+    }
+
+    template<typename Input, typename Output>
+    void operator()(
+        const Eigen::MatrixBase<Input> &input,
+        Eigen::MatrixBase<Output> *output) const
+    {
+        const Palette &colors = *this->palette_;
+        auto values = input.template reshaped<Eigen::AutoOrder>();
+        output->derived().resize(input.size(), colors.cols());
+
+        for (Eigen::Index i = 0; i < values.size(); ++i)
+        {
+            output->row(i) = colors.row(
+                this->GetIndex(static_cast<Value>(values(i))));
+        }
+    }
+
+    Pixels Filter(const Matrix &data) const
+    {
+        Pixels result{
+            typename Pixels::Data(data.size(), 3),
+            {data.cols(), data.rows()}};
+
+        (*this)(data, &result.data);
+
+        return result;
+    }
+
+    // pixels may be Pixels or a PixelsView, with the same size as data.
+    template<typename Derived, typename Result>
+    void Filter(const Eigen::MatrixBase<Derived> &data, Result &pixels) const
+    {
+        if (
+            pixels.size.height != data.rows()
+            || pixels.size.width != data.cols())
+        {
+            throw std::invalid_argument("pixels must match the size of data");
+        }
+
+        (*this)(data, &pixels.data);
+    }
+
+    template<typename Derived, typename Result>
+    void Filter(
+        const Eigen::MatrixBase<Derived> &data,
+        Result &pixels,
+        ThreadPool &threadPool) const
+    {
+        if (
+            pixels.size.height != data.rows()
+            || pixels.size.width != data.cols())
+        {
+            throw std::invalid_argument("pixels must match the size of data");
+        }
+
+        MapRowBands(*this, data, &pixels.data, threadPool);
+    }
+
+    const Palette & GetColors() const
+    {
+        return *this->palette_;
+    }
+
+private:
+    std::shared_ptr<const Palette> palette_;
+    Float scale_;
+    Float offset_;
+    Float last_;
+};
+
+
+/**
+ ** Maps signed values, such as the difference between two images, to
+ ** colors that diverge from white at zero: blue below and red above.
+ **
+ ** The range is symmetric, from -magnitude to magnitude, so differences of
+ ** equal size in either direction are equally saturated. Integral values of
+ ** 16 bits or fewer read RGB and packed RGBA tables that cover every value
+ ** of the type, so each pixel is one read, one table load and one write.
+ ** Other values are scaled to the palette with a multiply, a rounding and a
+ ** clamp, and NaN maps to white.
+ **/
+template<typename Value>
+class DivergingColorMap
+{
+public:
+    static_assert(std::is_arithmetic_v<Value>);
+
+    using Index = Eigen::Index;
+    using Word = uint32_t;
+    using Matrix = MonoImage<Value>;
+    using Pixels = RgbPixels<uint8_t>;
+    using Palette = RgbMatrix<uint8_t>;
+
+    using Float = std::conditional_t
+    <
+        std::is_same_v<Value, float> || sizeof(Value) <= 2,
+        float,
+        double
+    >;
+
+    static constexpr bool coversType =
+        std::is_integral_v<Value> && sizeof(Value) <= 2;
+
+    static constexpr size_t defaultHalfCount = 256;
+
+    // The palette has halfCount colors on each side of zero.
+    explicit DivergingColorMap(
+        Float magnitude,
+        size_t halfCount = defaultHalfCount)
+        :
+        palette_(),
+        scale_(),
+        center_(),
+        last_(),
+        colorTable_(),
+        packedTable_()
+    {
+        if (!(magnitude > 0))
+        {
+            throw std::invalid_argument("magnitude must be positive");
+        }
+
+        if (halfCount == 0)
+        {
+            throw std::invalid_argument("halfCount must be positive");
+        }
+
+        this->palette_ = diverging::MakeRgb8(halfCount);
+        this->scale_ = static_cast<Float>(halfCount) / magnitude;
+
+        this->center_ = static_cast<Float>(halfCount);
+        this->last_ = static_cast<Float>(2 * halfCount);
+
+        if constexpr (coversType)
+        {
+            static constexpr auto lowest =
+                static_cast<Index>(std::numeric_limits<Value>::lowest());
+
+            static constexpr auto highest =
+                static_cast<Index>(std::numeric_limits<Value>::max());
+
+            auto valueCount = highest - lowest + 1;
+            this->colorTable_.resize(valueCount, 3);
+            this->packedTable_.resize(static_cast<size_t>(valueCount));
+
+            for (Index value = lowest; value <= highest; ++value)
+            {
+                auto index = this->GetIndex(static_cast<Value>(value));
+
+                this->colorTable_.row(value - lowest) =
+                    this->palette_.row(index);
+
+                this->packedTable_[static_cast<size_t>(value - lowest)] =
+                    detail::PackRgba(this->palette_, index);
+            }
+        }
+        else
+        {
+            auto colorCount = static_cast<size_t>(this->palette_.rows());
+            this->packedTable_.resize(colorCount);
+
+            for (Index index = 0; index < this->palette_.rows(); ++index)
+            {
+                this->packedTable_[static_cast<size_t>(index)] =
+                    detail::PackRgba(this->palette_, index);
+            }
+        }
+    }
+
+    // Uses the larger magnitude of low and high.
+    static DivergingColorMap FromRange(
+        Value low,
+        Value high,
+        size_t halfCount = defaultHalfCount)
+    {
+        return DivergingColorMap(
+            std::max(
+                std::abs(static_cast<Float>(low)),
+                std::abs(static_cast<Float>(high))),
+            halfCount);
+    }
+
+    // The row of the palette for value.
+    Index GetIndex(Value value) const
+    {
+        Float scaled = static_cast<Float>(value) * this->scale_;
+
+        // Round half away from zero, so that value and -value select
+        // mirrored colors.
+        Float index = std::trunc(scaled + std::copysign(Float(0.5), scaled))
+            + this->center_;
+
+        if (index >= Float(0))
+        {
+            index = (index < this->last_) ? index : this->last_;
+        }
+        else if (index < Float(0))
+        {
+            index = Float(0);
+        }
+        else
+        {
+            // NaN
+            index = this->center_;
+        }
+
+        return static_cast<Index>(index);
+    }
+
+    template<typename Input, typename Output>
+    void operator()(
+        const Eigen::MatrixBase<Input> &input,
+        Eigen::MatrixBase<Output> *output) const
+    {
+        static_assert(std::is_same_v<typename Input::Scalar, Value>);
+
+        auto values = input.template reshaped<Eigen::AutoOrder>();
+        output->derived().resize(input.size(), 3);
+
+        if constexpr (coversType)
+        {
+            // Signed values index the table from its center.
+            static constexpr auto zero =
+                -static_cast<Index>(std::numeric_limits<Value>::lowest());
+
+            for (Index i = 0; i < values.size(); ++i)
+            {
+                output->row(i) = this->colorTable_.row(
+                    static_cast<Index>(values(i)) + zero);
+            }
+        }
+        else
+        {
+            for (Index i = 0; i < values.size(); ++i)
+            {
+                output->row(i) = this->palette_.row(this->GetIndex(values(i)));
+            }
+        }
+    }
+
+    // output must hold count words.
+    void operator()(const Value *input, Word *output, Index count) const
+    {
+        if constexpr (coversType)
+        {
+            const Word *table = this->packedTable_.data()
+                - static_cast<Index>(std::numeric_limits<Value>::lowest());
+
+            for (Index i = 0; i < count; ++i)
+            {
+                output[i] = table[input[i]];
+            }
+        }
+        else
+        {
+            const Word *table = this->packedTable_.data();
+
+            for (Index i = 0; i < count; ++i)
+            {
+                output[i] = table[this->GetIndex(input[i])];
+            }
+        }
+    }
+
+    /**
+     ** Writes packed RGBA words into packed, which must be contiguous with
+     ** the size and storage order of data, like a MonoImage<uint32_t>.
+     **/
+    template<typename Derived, typename Packed>
+    void FilterPacked(
+        const Eigen::MatrixBase<Derived> &data,
+        Eigen::MatrixBase<Packed> *packed) const
+    {
+        static_assert(std::is_same_v<typename Derived::Scalar, Value>);
+        detail::RequirePackedOutput(data, *packed);
+
+        (*this)(data.derived().data(), packed->derived().data(), data.size());
+    }
+
+    Pixels Filter(const Matrix &data) const
+    {
+        Pixels result{
+            typename Pixels::Data(data.size(), 3),
+            {data.cols(), data.rows()}};
+
+        (*this)(data, &result.data);
+
+        return result;
+    }
+
+    // pixels may be Pixels or a PixelsView, with the same size as data.
+    template<typename Derived, typename Result>
+    void Filter(const Eigen::MatrixBase<Derived> &data, Result &pixels) const
+    {
+        if (
+            pixels.size.height != data.rows()
+            || pixels.size.width != data.cols())
+        {
+            throw std::invalid_argument("pixels must match the size of data");
+        }
+
+        (*this)(data, &pixels.data);
+    }
+
+    const Palette & GetColors() const
+    {
+        return this->palette_;
+    }
+
+private:
+    Palette palette_;
+    Float scale_;
+    Float center_;
+    Float last_;
+
+    // Every value of the type, only when coversType.
+    Palette colorTable_;
+
+    // Every value of the type when coversType, otherwise the palette.
+    std::vector<Word> packedTable_;
 };
 
 
 extern template class ColorMap<int32_t>;
+extern template class AutoRangeColorMap<int32_t>;
+extern template class QuantizedColorMap<float>;
+extern template class QuantizedColorMap<double>;
+extern template class DivergingColorMap<int16_t>;
+extern template class DivergingColorMap<int32_t>;
+extern template class DivergingColorMap<float>;
 
 
 } // end namespace tau
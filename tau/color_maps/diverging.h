@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include "tau/eigen.h"
+#include "tau/color_maps/gradient.h"
+
+
+namespace tau
+{
+
+namespace diverging
+{
+
+
+/**
+ ** Two gradients that meet in white at the center entry: saturated blue
+ ** fading to white for negative values, and white deepening to red for
+ ** positive values.
+ **
+ ** The result has 2 * halfCount + 1 rows, and row halfCount is zero.
+ **/
+inline
+RgbMatrix<uint8_t> MakeRgb8(size_t halfCount)
+{
+    assert(halfCount > 0);
+
+    using Hsv = gradient::Hsv<double>;
+
+    auto negative = gradient::MakeColormap<uint8_t>(
+        halfCount + 1,
+        Hsv(240.0, 1.0, 1.0),
+        Hsv(240.0, 0.0, 1.0));
+
+    auto positive = gradient::MakeColormap<uint8_t>(
+        halfCount + 1,
+        Hsv(0.0, 0.0, 1.0),
+        Hsv(0.0, 1.0, 1.0));
+
+    auto half = static_cast<Eigen::Index>(halfCount);
+
+    RgbMatrix<uint8_t> result(2 * half + 1, 3);
+    result.topRows(half + 1) = negative;
+    result.bottomRows(half) = positive.bottomRows(half);
+
+    return result;
+}
+
+
+} // end namespace diverging
+
+
+} // end namespace tau
@@ -0,0 +1,264 @@
+#include "tau/compression_pipeline.h"
+
+#include <deque>
+#include <sstream>
+#include <jive/binary_io.h>
+
+
+namespace tau
+{
+
+
+CompressionSettings CompressionSettings::Default()
+{
+    return {
+        WaveletName::db4,
+        true,
+        0.1,
+        true,
+        false,
+        4096,
+        64};
+}
+
+
+std::string CompressSegment(
+    const Wavelet<double> &wavelet,
+    const Eigen::RowVector<double, Eigen::Dynamic> &segment,
+    const CompressionSettings &settings)
+{
+    auto decomposed = Decompose(wavelet, segment, settings.reflect);
+    double threshold = PreserveHighest(decomposed, settings.keepRatio);
+    double quantize = Quantize(decomposed, threshold);
+
+    std::ostringstream output;
+
+    jive::io::Write(output, static_cast<uint32_t>(segment.size()));
+    jive::io::Write(output, quantize);
+    Encode(
+        output,
+        decomposed,
+        settings.enableMultibyteZeros,
+        settings.enableGroupVarint);
+
+    return output.str();
+}
+
+
+Eigen::RowVector<double, Eigen::Dynamic> DecompressSegment(
+    const Wavelet<double> &wavelet,
+    std::istream &input,
+    bool reflect,
+    bool enableMultibyteZeros)
+{
+    auto sampleCount = static_cast<Eigen::Index>(
+        jive::io::Read<uint32_t>(input));
+
+    auto quantize = jive::io::Read<double>(input);
+    auto decomposed = Decode(input, enableMultibyteZeros);
+
+    for (auto &row: decomposed)
+    {
+        row.array() *= quantize;
+    }
+
+    auto requireSamples = [sampleCount](Eigen::Index available)
+    {
+        if (sampleCount > available)
+        {
+            throw std::runtime_error("Segment is shorter than its sampleCount");
+        }
+    };
+
+    if (decomposed.size() < 2)
+    {
+        // The segment was too short to decompose, and it was stored as-is.
+        const auto &stored = decomposed.at(0);
+        requireSamples(stored.size());
+
+        return stored.head(sampleCount);
+    }
+
+    // Recompose can produce one extra sample for odd signal lengths.
+    auto recomposed = Recompose(wavelet, decomposed, reflect);
+    requireSamples(recomposed.size());
+
+    return recomposed.head(sampleCount);
+}
+
+
+void CompressSegments(
+    std::ostream &output,
+    const Eigen::RowVector<double, Eigen::Dynamic> &signal,
+    const CompressionSettings &settings,
+    ThreadPool &threadPool)
+{
+    if (settings.segmentLength < 1)
+    {
+        throw std::invalid_argument("segmentLength must be positive");
+    }
+
+    auto wavelet = GetWavelet<double>(settings.wavelet);
+    auto signalLength = signal.size();
+
+    auto segmentCount = static_cast<uint64_t>(
+        (signalLength + settings.segmentLength - 1) / settings.segmentLength);
+
+    jive::io::Write(output, static_cast<uint8_t>(settings.wavelet));
+    jive::io::Write(output, static_cast<uint8_t>(settings.reflect));
+
+    jive::io::Write(
+        output,
+        static_cast<uint8_t>(settings.enableMultibyteZeros));
+
+    jive::io::Write(output, segmentCount);
+
+    // The reorder buffer.
+    // Futures are queued in signal order, so the front is always the next
+    // chunk to write, regardless of which worker finishes first.
+    std::deque<std::future<std::string>> pending;
+    auto maximumPending = std::max(settings.maximumPending, size_t{1});
+
+    auto writeFront = [&output, &pending]()
+    {
+        // Popped before get, so a job that throws is not waited on again.
+        auto front = std::move(pending.front());
+        pending.pop_front();
+        auto chunk = front.get();
+        jive::io::Write(output, static_cast<uint32_t>(chunk.size()));
+
+        output.write(
+            chunk.data(),
+            static_cast<std::streamsize>(chunk.size()));
+    };
+
+    try
+    {
+        for (
+            Eigen::Index start = 0;
+            start < signalLength;
+            start += settings.segmentLength)
+        {
+            if (pending.size() >= maximumPending)
+            {
+                writeFront();
+            }
+
+            auto length =
+                std::min(settings.segmentLength, signalLength - start);
+
+            pending.push_back(
+                threadPool.Submit(
+                    [&wavelet, &signal, &settings, start, length]()
+                    {
+                        return CompressSegment(
+                            wavelet,
+                            signal(Eigen::seqN(start, length)),
+                            settings);
+                    }));
+        }
+
+        while (!pending.empty())
+        {
+            writeFront();
+        }
+    }
+    catch (...)
+    {
+        // Queued jobs hold references to signal and settings.
+        // Let them finish before unwinding.
+        for (auto &chunk: pending)
+        {
+            if (chunk.valid())
+            {
+                chunk.wait();
+            }
+        }
+
+        throw;
+    }
+}
+
+
+Eigen::RowVector<double, Eigen::Dynamic> DecompressSegments(
+    std::istream &input,
+    ThreadPool &threadPool)
+{
+    auto waveletName = static_cast<WaveletName>(jive::io::Read<uint8_t>(input));
+    bool reflect = jive::io::Read<uint8_t>(input);
+    bool enableMultibyteZeros = jive::io::Read<uint8_t>(input);
+    auto segmentCount = jive::io::Read<uint64_t>(input);
+
+    auto wavelet = GetWavelet<double>(waveletName);
+
+    // segmentCount is not trusted to size allocations. A corrupt count
+    // fails at the first segment that cannot be read.
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+    std::vector<std::future<RowVector>> segments;
+    std::vector<RowVector> decompressed;
+    Eigen::Index sampleCount = 0;
+
+    try
+    {
+        for (uint64_t i = 0; i < segmentCount; ++i)
+        {
+            auto byteCount = jive::io::Read<uint32_t>(input);
+            std::string chunk(byteCount, '\0');
+            input.read(chunk.data(), static_cast<std::streamsize>(byteCount));
+
+            if (!input.good())
+            {
+                throw std::runtime_error("input is not good");
+            }
+
+            segments.push_back(
+                threadPool.Submit(
+                    [&wavelet, reflect, enableMultibyteZeros,
+                        chunk = std::move(chunk)]()
+                    {
+                        std::istringstream chunkInput(chunk);
+
+                        return DecompressSegment(
+                            wavelet,
+                            chunkInput,
+                            reflect,
+                            enableMultibyteZeros);
+                    }));
+        }
+
+        decompressed.reserve(segments.size());
+
+        for (auto &segment: segments)
+        {
+            decompressed.push_back(segment.get());
+            sampleCount += decompressed.back().size();
+        }
+    }
+    catch (...)
+    {
+        // Queued jobs hold a reference to wavelet.
+        for (auto &segment: segments)
+        {
+            if (segment.valid())
+            {
+                segment.wait();
+            }
+        }
+
+        throw;
+    }
+
+    RowVector result(sampleCount);
+    Eigen::Index start = 0;
+
+    for (auto &segment: decompressed)
+    {
+        result(Eigen::seqN(start, segment.size())) = segment;
+        start += segment.size();
+    }
+
+    return result;
+}
+
+
+} // end namespace tau
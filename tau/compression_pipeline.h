@@ -0,0 +1,90 @@
+#pragma once
+
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <fields/fields.h>
+
+#include "tau/wavelet.h"
+#include "tau/wavelet_compression.h"
+#include "tau/thread_pool.h"
+
+
+namespace tau
+{
+
+
+struct CompressionSettings
+{
+    WaveletName wavelet;
+    bool reflect;
+    double keepRatio;
+    bool enableMultibyteZeros;
+
+    // Selects the group varint row coding, for faster decoding.
+    bool enableGroupVarint;
+
+    // The signal is cut into segments of this many samples. The last segment
+    // holds the remainder.
+    Eigen::Index segmentLength;
+
+    // The count of encoded segments allowed to wait in the reorder buffer
+    // before the writer blocks on the oldest one.
+    size_t maximumPending;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&CompressionSettings::wavelet, "wavelet"),
+        fields::Field(&CompressionSettings::reflect, "reflect"),
+        fields::Field(&CompressionSettings::keepRatio, "keepRatio"),
+        fields::Field(
+            &CompressionSettings::enableMultibyteZeros,
+            "enableMultibyteZeros"),
+        fields::Field(
+            &CompressionSettings::enableGroupVarint,
+            "enableGroupVarint"),
+        fields::Field(&CompressionSettings::segmentLength, "segmentLength"),
+        fields::Field(&CompressionSettings::maximumPending, "maximumPending"));
+
+    static CompressionSettings Default();
+};
+
+
+/**
+ ** Runs Decompose -> PreserveHighest -> Quantize -> Encode on one segment.
+ **
+ ** The returned chunk is self-describing: it carries the sample count and the
+ ** quantization factor needed by DecompressSegment.
+ **/
+std::string CompressSegment(
+    const Wavelet<double> &wavelet,
+    const Eigen::RowVector<double, Eigen::Dynamic> &segment,
+    const CompressionSettings &settings);
+
+
+Eigen::RowVector<double, Eigen::Dynamic> DecompressSegment(
+    const Wavelet<double> &wavelet,
+    std::istream &input,
+    bool reflect,
+    bool enableMultibyteZeros);
+
+
+/**
+ ** Compresses each segment of signal on the thread pool.
+ **
+ ** Segments finish in any order, but chunks are written to output in signal
+ ** order.
+ **/
+void CompressSegments(
+    std::ostream &output,
+    const Eigen::RowVector<double, Eigen::Dynamic> &signal,
+    const CompressionSettings &settings,
+    ThreadPool &threadPool);
+
+
+Eigen::RowVector<double, Eigen::Dynamic> DecompressSegments(
+    std::istream &input,
+    ThreadPool &threadPool);
+
+
+} // end namespace tau
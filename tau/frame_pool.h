@@ -0,0 +1,300 @@
+#pragma once
+
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <fields/fields.h>
+
+#include "tau/eigen.h"
+#include "tau/size.h"
+
+
+namespace tau
+{
+
+
+struct FramePoolCounts
+{
+    // Acquired frames that were recycled.
+    size_t hitCount;
+
+    // Acquired frames that had to be allocated.
+    size_t missCount;
+
+    // Released frames kept for reuse.
+    size_t recycledCount;
+
+    // Released frames freed because the pool was full.
+    size_t discardedCount;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&FramePoolCounts::hitCount, "hitCount"),
+        fields::Field(&FramePoolCounts::missCount, "missCount"),
+        fields::Field(&FramePoolCounts::recycledCount, "recycledCount"),
+        fields::Field(&FramePoolCounts::discardedCount, "discardedCount"));
+};
+
+
+namespace detail
+{
+
+
+template<typename Frame, typename = int>
+struct HasCreate_: std::false_type {};
+
+template<typename Frame>
+struct HasCreate_
+<
+    Frame,
+    decltype((void)Frame::Create(std::declval<Size<Eigen::Index>>()), 0)
+>
+    :
+    std::true_type
+{
+
+};
+
+
+// Pixels are created with Create(size), and Eigen matrices by their
+// dimensions.
+template<typename Frame>
+Frame * MakeFrame(const Size<Eigen::Index> &size)
+{
+    if constexpr (HasCreate_<Frame>::value)
+    {
+        return new Frame(Frame::Create(size));
+    }
+    else
+    {
+        return new Frame(size.height, size.width);
+    }
+}
+
+
+} // end namespace detail
+
+
+/**
+ ** Recycles frames of one size, such as Pixels or MonoImage.
+ **
+ ** Acquire returns a shared_ptr whose deleter gives the frame back to the
+ ** pool, so the buffers of a steady stream are allocated once. A released
+ ** frame is freed instead when every slot is full, or when the pool has
+ ** been destroyed.
+ **
+ ** Acquire and release exchange frame pointers with atomic slots, and take
+ ** no locks. Recycled frames keep the contents they were released with.
+ **/
+template<typename Frame>
+class FramePool: public std::enable_shared_from_this<FramePool<Frame>>
+{
+public:
+    using Index = Eigen::Index;
+
+    static std::shared_ptr<FramePool> Create(
+        const Size<Index> &size,
+        size_t capacity = 8)
+    {
+        return std::shared_ptr<FramePool>(new FramePool(size, capacity));
+    }
+
+    ~FramePool()
+    {
+        for (auto &slot: this->slots_)
+        {
+            delete slot.exchange(nullptr);
+        }
+    }
+
+    FramePool(const FramePool &) = delete;
+    FramePool & operator=(const FramePool &) = delete;
+
+    std::shared_ptr<Frame> Acquire()
+    {
+        Frame *frame = nullptr;
+
+        for (auto &slot: this->slots_)
+        {
+            if (slot.load(std::memory_order_relaxed))
+            {
+                frame = slot.exchange(nullptr, std::memory_order_acquire);
+
+                if (frame)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (frame)
+        {
+            this->hitCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            this->missCount_.fetch_add(1, std::memory_order_relaxed);
+            frame = detail::MakeFrame<Frame>(this->size_);
+        }
+
+        std::weak_ptr<FramePool> pool = this->weak_from_this();
+
+        return std::shared_ptr<Frame>(
+            frame,
+            [pool](Frame *released)
+            {
+                if (auto owner = pool.lock())
+                {
+                    owner->Release_(released);
+                }
+                else
+                {
+                    delete released;
+                }
+            });
+    }
+
+    const Size<Index> & GetSize() const
+    {
+        return this->size_;
+    }
+
+    size_t GetCapacity() const
+    {
+        return this->slots_.size();
+    }
+
+    FramePoolCounts GetCounts() const
+    {
+        return {
+            this->hitCount_.load(std::memory_order_relaxed),
+            this->missCount_.load(std::memory_order_relaxed),
+            this->recycledCount_.load(std::memory_order_relaxed),
+            this->discardedCount_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    FramePool(const Size<Index> &size, size_t capacity)
+        :
+        size_(size),
+        slots_(capacity),
+        hitCount_(0),
+        missCount_(0),
+        recycledCount_(0),
+        discardedCount_(0)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("capacity must be at least 1");
+        }
+
+        for (auto &slot: this->slots_)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    void Release_(Frame *frame)
+    {
+        for (auto &slot: this->slots_)
+        {
+            Frame *empty = nullptr;
+
+            if (
+                slot.compare_exchange_strong(
+                    empty,
+                    frame,
+                    std::memory_order_release,
+                    std::memory_order_relaxed))
+            {
+                this->recycledCount_.fetch_add(1, std::memory_order_relaxed);
+
+                return;
+            }
+        }
+
+        this->discardedCount_.fetch_add(1, std::memory_order_relaxed);
+        delete frame;
+    }
+
+    Size<Index> size_;
+    std::vector<std::atomic<Frame *>> slots_;
+    std::atomic<size_t> hitCount_;
+    std::atomic<size_t> missCount_;
+    std::atomic<size_t> recycledCount_;
+    std::atomic<size_t> discardedCount_;
+};
+
+
+/**
+ ** A FramePool for each frame size.
+ **
+ ** Get locks to find or create the pool, so look up the pool when the size
+ ** changes and keep it, rather than calling Get for every frame.
+ **/
+template<typename Frame>
+class FramePools
+{
+public:
+    using Index = Eigen::Index;
+    using Pool = FramePool<Frame>;
+
+    explicit FramePools(size_t capacity = 8)
+        :
+        capacity_(capacity),
+        mutex_(),
+        pools_()
+    {
+
+    }
+
+    std::shared_ptr<Pool> Get(const Size<Index> &size)
+    {
+        std::lock_guard lock(this->mutex_);
+
+        auto &pool = this->pools_[{size.height, size.width}];
+
+        if (!pool)
+        {
+            pool = Pool::Create(size, this->capacity_);
+        }
+
+        return pool;
+    }
+
+    std::shared_ptr<Frame> Acquire(const Size<Index> &size)
+    {
+        return this->Get(size)->Acquire();
+    }
+
+    // The counts of every pool combined.
+    FramePoolCounts GetCounts() const
+    {
+        std::lock_guard lock(this->mutex_);
+        FramePoolCounts result{0, 0, 0, 0};
+
+        for (auto &entry: this->pools_)
+        {
+            auto counts = entry.second->GetCounts();
+            result.hitCount += counts.hitCount;
+            result.missCount += counts.missCount;
+            result.recycledCount += counts.recycledCount;
+            result.discardedCount += counts.discardedCount;
+        }
+
+        return result;
+    }
+
+private:
+    size_t capacity_;
+    mutable std::mutex mutex_;
+
+    // Keyed by height, then width.
+    std::map<std::pair<Index, Index>, std::shared_ptr<Pool>> pools_;
+};
+
+
+} // end namespace tau
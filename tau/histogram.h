@@ -0,0 +1,195 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include <tau/eigen.h>
+
+
+namespace tau
+{
+
+
+/**
+ ** Counts values from a stream of frames in fixed bins, so percentiles can
+ ** be found in O(binCount) instead of by sorting each frame.
+ **
+ ** Before each frame is added, the counts of earlier frames are multiplied
+ ** by retention. A retention of 0 describes only the latest frame, and a
+ ** retention near 1 smooths the percentiles over many frames.
+ **
+ ** Values outside [minimum, maximum] are counted in the first or last bin.
+ ** NaN is ignored. With integral values and one bin for each value,
+ ** GetPercentile matches Percentile exactly.
+ **/
+template<typename Value>
+class StreamingHistogram
+{
+public:
+    static_assert(std::is_arithmetic_v<Value>);
+
+    StreamingHistogram(
+        Value minimum,
+        Value maximum,
+        size_t binCount,
+        double retention = 0.0)
+        :
+        minimum_(minimum),
+        scale_(),
+        retention_(retention),
+        total_(0),
+        counts_(binCount, 0.0)
+    {
+        if (!(minimum < maximum))
+        {
+            throw std::invalid_argument("minimum must be less than maximum");
+        }
+
+        if (binCount == 0)
+        {
+            throw std::invalid_argument("binCount must be positive");
+        }
+
+        if (!(retention >= 0.0 && retention <= 1.0))
+        {
+            throw std::invalid_argument("retention must be in [0, 1]");
+        }
+
+        // Integral bins include both ends of the range.
+        double span =
+            static_cast<double>(maximum) - static_cast<double>(minimum);
+
+        if constexpr (std::is_integral_v<Value>)
+        {
+            span += 1.0;
+        }
+
+        this->scale_ = static_cast<double>(binCount) / span;
+    }
+
+    template<typename Derived>
+    void AddFrame(const Eigen::DenseBase<Derived> &frame)
+    {
+        if (this->retention_ != 1.0)
+        {
+            for (auto &count: this->counts_)
+            {
+                count *= this->retention_;
+            }
+
+            this->total_ *= this->retention_;
+        }
+
+        auto values = frame.derived().reshaped();
+        double added = 0;
+
+        for (Eigen::Index i = 0; i < values.size(); ++i)
+        {
+            auto value = static_cast<Value>(values(i));
+
+            if constexpr (std::is_floating_point_v<Value>)
+            {
+                if (std::isnan(value))
+                {
+                    continue;
+                }
+            }
+
+            this->counts_[this->GetBin(value)] += 1.0;
+            added += 1.0;
+        }
+
+        this->total_ += added;
+    }
+
+    size_t GetBin(Value value) const
+    {
+        double bin = std::floor(
+            (static_cast<double>(value) - static_cast<double>(this->minimum_))
+            * this->scale_);
+
+        auto last = static_cast<double>(this->counts_.size() - 1);
+
+        return static_cast<size_t>(std::clamp(bin, 0.0, last));
+    }
+
+    // The smallest value counted in bin.
+    Value GetBinValue(size_t bin) const
+    {
+        double target = static_cast<double>(bin);
+        double offset = target / this->scale_;
+
+        if constexpr (std::is_integral_v<Value>)
+        {
+            // The smallest whole offset in bin, corrected for the rounding
+            // error of the division.
+            offset = std::ceil(offset);
+
+            if (
+                offset > 0.0
+                && std::floor((offset - 1.0) * this->scale_) >= target)
+            {
+                offset -= 1.0;
+            }
+            else if (std::floor(offset * this->scale_) < target)
+            {
+                offset += 1.0;
+            }
+        }
+
+        return static_cast<Value>(
+            static_cast<double>(this->minimum_) + offset);
+    }
+
+    // The value below which the fraction percentile of the counts lie.
+    Value GetPercentile(double percentile) const
+    {
+        if (this->total_ <= 0.0)
+        {
+            return this->minimum_;
+        }
+
+        double rank = percentile * this->total_;
+        double cumulative = 0;
+
+        for (size_t bin = 0; bin < this->counts_.size(); ++bin)
+        {
+            cumulative += this->counts_[bin];
+
+            if (cumulative > rank)
+            {
+                return this->GetBinValue(bin);
+            }
+        }
+
+        return this->GetBinValue(this->counts_.size() - 1);
+    }
+
+    double GetTotal() const
+    {
+        return this->total_;
+    }
+
+    const std::vector<double> & GetCounts() const
+    {
+        return this->counts_;
+    }
+
+    void Reset()
+    {
+        std::fill(this->counts_.begin(), this->counts_.end(), 0.0);
+        this->total_ = 0;
+    }
+
+private:
+    Value minimum_;
+    double scale_;
+    double retention_;
+    double total_;
+    std::vector<double> counts_;
+};
+
+
+} // end namespace tau
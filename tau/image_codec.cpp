@@ -0,0 +1,613 @@
+#include "tau/image_codec.h"
+
+#include <future>
+#include <sstream>
+#include <fmt/core.h>
+#include <jive/binary_io.h>
+
+#include "tau/wavelet2d.h"
+#include "tau/wavelet_compression.h"
+
+
+namespace tau
+{
+
+
+ImageCodecSettings ImageCodecSettings::Default()
+{
+    return {WaveletName::db2, 0.1, true, false, 256, 4};
+}
+
+
+namespace detail
+{
+
+
+using Index = Eigen::Index;
+using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+
+struct ImageHeader
+{
+    WaveletName wavelet;
+    size_t levelCount;
+    Index rowCount;
+    Index columnCount;
+    Index tileSize;
+    size_t planeCount;
+};
+
+
+// A tile's position and size in the image, in pixels.
+struct Tile
+{
+    Index row;
+    Index column;
+    Index rowCount;
+    Index columnCount;
+};
+
+
+std::vector<Tile> GetTiles(const ImageHeader &header)
+{
+    std::vector<Tile> result;
+
+    for (Index row = 0; row < header.rowCount; row += header.tileSize)
+    {
+        for (
+            Index column = 0;
+            column < header.columnCount;
+            column += header.tileSize)
+        {
+            result.push_back({
+                row,
+                column,
+                std::min(header.tileSize, header.rowCount - row),
+                std::min(header.tileSize, header.columnCount - column)});
+        }
+    }
+
+    return result;
+}
+
+
+size_t GetTileLevelCount(
+    const Wavelet<double> &wavelet,
+    size_t levelCount,
+    const Tile &tile)
+{
+    return std::min(
+        levelCount,
+        GetMaximumLevel2d(wavelet, tile.rowCount, tile.columnCount));
+}
+
+
+// Flattens the bands, coarsest first, into rows for Encode.
+Decomposed<double> ToRows(const Decomposed2d<double> &decomposed)
+{
+    Decomposed<double> result;
+
+    auto append = [&result](const MonoImage<double> &band)
+    {
+        result.push_back(
+            Eigen::Map<const RowVector>(band.data(), band.size()));
+    };
+
+    append(decomposed.approximation);
+
+    for (auto &bands: decomposed.details)
+    {
+        for (auto &band: bands)
+        {
+            append(band);
+        }
+    }
+
+    return result;
+}
+
+
+// Restores the band shapes, which follow from the tile size and the filter
+// length.
+Decomposed2d<double> FromRows(
+    const Decomposed<double> &rows,
+    const Wavelet<double> &wavelet,
+    const Tile &tile,
+    size_t levelCount)
+{
+    if (rows.size() != 1 + 3 * levelCount)
+    {
+        throw std::runtime_error("Tile band count does not match");
+    }
+
+    auto filterLength = wavelet.decompose.low.size();
+    Index rowCount = tile.rowCount;
+    Index columnCount = tile.columnCount;
+
+    Decomposed2d<double> result{
+        {},
+        std::vector<std::array<MonoImage<double>, 3>>(levelCount),
+        tile.rowCount,
+        tile.columnCount};
+
+    auto toBand = [&rows, &rowCount, &columnCount](size_t index)
+    {
+        auto &row = rows[index];
+
+        if (row.size() != rowCount * columnCount)
+        {
+            throw std::runtime_error("Tile band size does not match");
+        }
+
+        return MonoImage<double>(
+            Eigen::Map<const MonoImage<double>>(
+                row.data(),
+                rowCount,
+                columnCount));
+    };
+
+    // Bands are stored coarsest first, and sizes are known finest first.
+    for (size_t level = 0; level < levelCount; ++level)
+    {
+        rowCount = (rowCount + filterLength - 1) / 2;
+        columnCount = (columnCount + filterLength - 1) / 2;
+
+        auto first = 1 + 3 * (levelCount - 1 - level);
+        auto &bands = result.details[levelCount - 1 - level];
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            bands[i] = toBand(first + i);
+        }
+    }
+
+    result.approximation = toBand(0);
+
+    return result;
+}
+
+
+std::string EncodeTile(
+    const Wavelet<double> &wavelet,
+    const MonoImage<uint16_t> &plane,
+    const Tile &tile,
+    const ImageCodecSettings &settings)
+{
+    MonoImage<double> pixels = plane.block(
+        tile.row,
+        tile.column,
+        tile.rowCount,
+        tile.columnCount).cast<double>();
+
+    auto levelCount = GetTileLevelCount(wavelet, settings.levelCount, tile);
+    auto rows = ToRows(Decompose2d(wavelet, pixels, true, levelCount));
+
+    // Tiles cut too thin by the image edge to decompose hold raw pixels.
+    // They are kept without loss, because a threshold on pixel values would
+    // quantize them far more coarsely than the coefficients around them.
+    double threshold = 1.0;
+
+    if (levelCount > 0)
+    {
+        threshold = PreserveHighest(rows, settings.keepRatio);
+    }
+
+    double quantize = Quantize(rows, threshold);
+
+    std::ostringstream output;
+    jive::io::Write(output, quantize);
+
+    Encode(
+        output,
+        rows,
+        settings.enableMultibyteZeros,
+        settings.enableGroupVarint);
+
+    return output.str();
+}
+
+
+MonoImage<uint16_t> DecodeTile(
+    const Wavelet<double> &wavelet,
+    const std::string &chunk,
+    const Tile &tile,
+    size_t levelCount)
+{
+    std::istringstream input(chunk);
+    auto quantize = jive::io::Read<double>(input);
+    auto rows = Decode(input, true);
+
+    for (auto &row: rows)
+    {
+        row.array() *= quantize;
+    }
+
+    auto recomposed = Recompose2d(
+        wavelet,
+        FromRows(
+            rows,
+            wavelet,
+            tile,
+            GetTileLevelCount(wavelet, levelCount, tile)),
+        true);
+
+    return recomposed.array()
+        .round()
+        .max(0.0)
+        .min(static_cast<double>(std::numeric_limits<uint16_t>::max()))
+        .cast<uint16_t>();
+}
+
+
+void WriteHeader(std::ostream &output, const ImageHeader &header)
+{
+    for (auto byte: image::magic)
+    {
+        jive::io::Write(output, byte);
+    }
+
+    jive::io::Write(output, image::version);
+    jive::io::Write(output, static_cast<uint8_t>(header.wavelet));
+    WriteVarint(output, header.levelCount);
+    WriteVarint(output, static_cast<uint64_t>(header.rowCount));
+    WriteVarint(output, static_cast<uint64_t>(header.columnCount));
+    WriteVarint(output, static_cast<uint64_t>(header.tileSize));
+    WriteVarint(output, header.planeCount);
+}
+
+
+ImageHeader ReadHeader(std::istream &input)
+{
+    for (auto byte: image::magic)
+    {
+        if (jive::io::Read<uint8_t>(input) != byte)
+        {
+            throw std::runtime_error("Bad magic");
+        }
+    }
+
+    auto version = jive::io::Read<uint8_t>(input);
+
+    if (version != image::version)
+    {
+        throw std::runtime_error(
+            fmt::format("Unsupported version: {}", version));
+    }
+
+    ImageHeader header;
+    header.wavelet = static_cast<WaveletName>(jive::io::Read<uint8_t>(input));
+    header.levelCount = ReadVarint(input);
+    header.rowCount = static_cast<Index>(ReadVarint(input));
+    header.columnCount = static_cast<Index>(ReadVarint(input));
+    header.tileSize = static_cast<Index>(ReadVarint(input));
+    header.planeCount = ReadVarint(input);
+
+    if (header.tileSize < 1)
+    {
+        throw std::runtime_error("Bad tile size");
+    }
+
+    return header;
+}
+
+
+template<typename Result>
+void WaitAll(std::vector<std::future<Result>> &futures)
+{
+    for (auto &future: futures)
+    {
+        if (future.valid())
+        {
+            future.wait();
+        }
+    }
+}
+
+
+// Decodes the tiles that intersect rows [top, bottom) and columns
+// [left, right), and copies that part of each plane to the result.
+ImagePlanes DecodeRegion(
+    std::istream &input,
+    Index top,
+    Index left,
+    Index bottom,
+    Index right,
+    const ImageHeader &header,
+    ThreadPool &threadPool)
+{
+    auto tiles = GetTiles(header);
+    auto tileCount = tiles.size() * header.planeCount;
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(tileCount + 1);
+    offsets.push_back(0);
+
+    for (size_t i = 0; i < tileCount; ++i)
+    {
+        offsets.push_back(offsets.back() + ReadVarint(input));
+    }
+
+    auto dataStart = input.tellg();
+    uint64_t position = 0;
+
+    auto wavelet = GetWavelet<double>(header.wavelet);
+
+    ImagePlanes result(
+        header.planeCount,
+        MonoImage<uint16_t>(bottom - top, right - left));
+
+    // The index of each requested tile, and its decoded pixels.
+    std::vector<size_t> indices;
+    std::vector<std::future<MonoImage<uint16_t>>> decoded;
+
+    try
+    {
+        for (size_t i = 0; i < tileCount; ++i)
+        {
+            auto &tile = tiles[i % tiles.size()];
+
+            bool intersects =
+                tile.row < bottom
+                && tile.row + tile.rowCount > top
+                && tile.column < right
+                && tile.column + tile.columnCount > left;
+
+            if (!intersects)
+            {
+                continue;
+            }
+
+            if (position != offsets[i])
+            {
+                input.seekg(
+                    dataStart + static_cast<std::streamoff>(offsets[i]));
+
+                position = offsets[i];
+            }
+
+            auto byteCount = offsets[i + 1] - offsets[i];
+            std::string chunk(byteCount, '\0');
+            input.read(chunk.data(), static_cast<std::streamsize>(byteCount));
+
+            if (!input.good())
+            {
+                throw std::runtime_error("input is not good");
+            }
+
+            position += byteCount;
+            indices.push_back(i);
+
+            decoded.push_back(
+                threadPool.Submit(
+                    [&wavelet, &tile, &header, chunk = std::move(chunk)]()
+                    {
+                        return DecodeTile(
+                            wavelet,
+                            chunk,
+                            tile,
+                            header.levelCount);
+                    }));
+        }
+
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            auto pixels = decoded[i].get();
+            auto &tile = tiles[indices[i] % tiles.size()];
+            auto &plane = result[indices[i] / tiles.size()];
+
+            auto firstRow = std::max(top, tile.row);
+            auto firstColumn = std::max(left, tile.column);
+
+            auto rowCount =
+                std::min(bottom, tile.row + tile.rowCount) - firstRow;
+
+            auto columnCount =
+                std::min(right, tile.column + tile.columnCount) - firstColumn;
+
+            plane.block(
+                firstRow - top,
+                firstColumn - left,
+                rowCount,
+                columnCount) =
+                    pixels.block(
+                        firstRow - tile.row,
+                        firstColumn - tile.column,
+                        rowCount,
+                        columnCount);
+        }
+    }
+    catch (...)
+    {
+        // Queued jobs hold references to wavelet, tiles, and header.
+        WaitAll(decoded);
+
+        throw;
+    }
+
+    return result;
+}
+
+
+} // end namespace detail
+
+
+void EncodeImagePlanes(
+    std::ostream &output,
+    const ImagePlanes &planes,
+    const ImageCodecSettings &settings,
+    ThreadPool &threadPool)
+{
+    if (settings.tileSize < 1)
+    {
+        throw std::invalid_argument("tileSize must be positive");
+    }
+
+    Eigen::Index rowCount = 0;
+    Eigen::Index columnCount = 0;
+
+    if (!planes.empty())
+    {
+        rowCount = planes.front().rows();
+        columnCount = planes.front().cols();
+    }
+
+    for (auto &plane: planes)
+    {
+        if (plane.rows() != rowCount || plane.cols() != columnCount)
+        {
+            throw std::invalid_argument("Planes must have the same size");
+        }
+    }
+
+    detail::ImageHeader header{
+        settings.wavelet,
+        settings.levelCount,
+        rowCount,
+        columnCount,
+        settings.tileSize,
+        planes.size()};
+
+    auto tiles = detail::GetTiles(header);
+    auto wavelet = GetWavelet<double>(settings.wavelet);
+    std::vector<std::future<std::string>> encoded;
+    std::vector<std::string> chunks;
+
+    try
+    {
+        for (auto &plane: planes)
+        {
+            for (auto &tile: tiles)
+            {
+                encoded.push_back(
+                    threadPool.Submit(
+                        [&wavelet, &plane, &tile, &settings]()
+                        {
+                            return detail::EncodeTile(
+                                wavelet,
+                                plane,
+                                tile,
+                                settings);
+                        }));
+            }
+        }
+
+        for (auto &chunk: encoded)
+        {
+            chunks.push_back(chunk.get());
+        }
+    }
+    catch (...)
+    {
+        // Queued jobs hold references to planes, tiles, and settings.
+        detail::WaitAll(encoded);
+
+        throw;
+    }
+
+    detail::WriteHeader(output, header);
+
+    for (auto &chunk: chunks)
+    {
+        WriteVarint(output, chunk.size());
+    }
+
+    for (auto &chunk: chunks)
+    {
+        output.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+}
+
+
+ImagePlanes DecodeImagePlanes(std::istream &input, ThreadPool &threadPool)
+{
+    auto header = detail::ReadHeader(input);
+
+    return detail::DecodeRegion(
+        input,
+        0,
+        0,
+        header.rowCount,
+        header.columnCount,
+        header,
+        threadPool);
+}
+
+
+ImagePlanes DecodeImagePlanes(
+    std::istream &input,
+    const IntRegion &region,
+    ThreadPool &threadPool)
+{
+    auto header = detail::ReadHeader(input);
+
+    // Clip the region to the image.
+    auto top = std::clamp<Eigen::Index>(region.topLeft.y, 0, header.rowCount);
+
+    auto left =
+        std::clamp<Eigen::Index>(region.topLeft.x, 0, header.columnCount);
+
+    auto bottom = std::clamp<Eigen::Index>(
+        Eigen::Index{region.topLeft.y} + region.size.height,
+        top,
+        header.rowCount);
+
+    auto right = std::clamp<Eigen::Index>(
+        Eigen::Index{region.topLeft.x} + region.size.width,
+        left,
+        header.columnCount);
+
+    return detail::DecodeRegion(
+        input,
+        top,
+        left,
+        bottom,
+        right,
+        header,
+        threadPool);
+}
+
+
+void EncodeImage(
+    std::ostream &output,
+    const MonoImage<uint16_t> &image,
+    const ImageCodecSettings &settings,
+    ThreadPool &threadPool)
+{
+    EncodeImagePlanes(output, ImagePlanes{image}, settings, threadPool);
+}
+
+
+namespace detail
+{
+
+
+MonoImage<uint16_t> ToImage(ImagePlanes &&planes)
+{
+    if (planes.size() != 1)
+    {
+        throw std::runtime_error("Expected a single plane");
+    }
+
+    return std::move(planes.front());
+}
+
+
+} // end namespace detail
+
+
+MonoImage<uint16_t> DecodeImage(std::istream &input, ThreadPool &threadPool)
+{
+    return detail::ToImage(DecodeImagePlanes(input, threadPool));
+}
+
+
+MonoImage<uint16_t> DecodeImage(
+    std::istream &input,
+    const IntRegion &region,
+    ThreadPool &threadPool)
+{
+    return detail::ToImage(DecodeImagePlanes(input, region, threadPool));
+}
+
+
+} // end namespace tau
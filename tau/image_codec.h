@@ -0,0 +1,186 @@
+#pragma once
+
+
+#include <array>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <fields/fields.h>
+
+#include "tau/mono_image.h"
+#include "tau/planar.h"
+#include "tau/region.h"
+#include "tau/thread_pool.h"
+#include "tau/wavelet.h"
+
+
+namespace tau
+{
+
+
+struct ImageCodecSettings
+{
+    WaveletName wavelet;
+    double keepRatio;
+    bool enableMultibyteZeros;
+    bool enableGroupVarint;
+
+    // Tiles are square, except where they are cut short by the image edges.
+    Eigen::Index tileSize;
+
+    // The count of 2D decomposition levels in each tile. Small tiles use
+    // fewer.
+    size_t levelCount;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&ImageCodecSettings::wavelet, "wavelet"),
+        fields::Field(&ImageCodecSettings::keepRatio, "keepRatio"),
+        fields::Field(
+            &ImageCodecSettings::enableMultibyteZeros,
+            "enableMultibyteZeros"),
+        fields::Field(
+            &ImageCodecSettings::enableGroupVarint,
+            "enableGroupVarint"),
+        fields::Field(&ImageCodecSettings::tileSize, "tileSize"),
+        fields::Field(&ImageCodecSettings::levelCount, "levelCount"));
+
+    static ImageCodecSettings Default();
+};
+
+
+/**
+ ** Tiled wavelet image coding.
+ **
+ ** Each tile of each plane is decomposed with Decompose2d, and its bands are
+ ** quantized and written with Encode, independently of the other tiles.
+ ** Tiles are coded in parallel on the thread pool.
+ **
+ ** Layout:
+ **
+ **     magic (4 bytes) | version (1 byte) | wavelet (1 byte)
+ **     | level count (varint) | row count (varint) | column count (varint)
+ **     | tile size (varint) | plane count (varint)
+ **     | tile byte counts (varint each) | tiles
+ **
+ ** Tiles are ordered by plane, then row, then column. Each tile holds its
+ ** quantize factor (double) followed by the Encode payload of its bands:
+ ** the approximation, then the three detail bands of each level, each
+ ** flattened in row-major order.
+ **
+ ** The byte counts let a region be decoded by seeking to only the tiles that
+ ** intersect it.
+ **/
+namespace image
+{
+
+inline constexpr std::array<uint8_t, 4> magic{0xFF, 'T', 'W', 'I'};
+inline constexpr uint8_t version = 1;
+
+} // end namespace image
+
+
+using ImagePlanes = std::vector<MonoImage<uint16_t>>;
+
+
+// All planes must have the same size.
+void EncodeImagePlanes(
+    std::ostream &output,
+    const ImagePlanes &planes,
+    const ImageCodecSettings &settings,
+    ThreadPool &threadPool);
+
+
+ImagePlanes DecodeImagePlanes(std::istream &input, ThreadPool &threadPool);
+
+
+/**
+ ** Decodes only the tiles that intersect region, and returns the part of
+ ** region that lies within the image. input must be seekable.
+ **/
+ImagePlanes DecodeImagePlanes(
+    std::istream &input,
+    const IntRegion &region,
+    ThreadPool &threadPool);
+
+
+void EncodeImage(
+    std::ostream &output,
+    const MonoImage<uint16_t> &image,
+    const ImageCodecSettings &settings,
+    ThreadPool &threadPool);
+
+
+MonoImage<uint16_t> DecodeImage(std::istream &input, ThreadPool &threadPool);
+
+
+MonoImage<uint16_t> DecodeImage(
+    std::istream &input,
+    const IntRegion &region,
+    ThreadPool &threadPool);
+
+
+template<size_t count, int options>
+using PlanarImage =
+    Planar<count, uint16_t, Eigen::Dynamic, Eigen::Dynamic, options>;
+
+
+template<size_t count, int options>
+void EncodePlanar(
+    std::ostream &output,
+    const PlanarImage<count, options> &planar,
+    const ImageCodecSettings &settings,
+    ThreadPool &threadPool)
+{
+    ImagePlanes planes(std::begin(planar.planes), std::end(planar.planes));
+    EncodeImagePlanes(output, planes, settings, threadPool);
+}
+
+
+namespace detail
+{
+
+
+template<size_t count, int options>
+PlanarImage<count, options> ToPlanar(const ImagePlanes &planes)
+{
+    if (planes.size() != count)
+    {
+        throw std::runtime_error("Plane count does not match");
+    }
+
+    PlanarImage<count, options> result;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        result.planes[i] = planes[i];
+    }
+
+    return result;
+}
+
+
+} // end namespace detail
+
+
+template<size_t count, int options = Eigen::ColMajor>
+PlanarImage<count, options> DecodePlanar(
+    std::istream &input,
+    ThreadPool &threadPool)
+{
+    return detail::ToPlanar<count, options>(
+        DecodeImagePlanes(input, threadPool));
+}
+
+
+template<size_t count, int options = Eigen::ColMajor>
+PlanarImage<count, options> DecodePlanar(
+    std::istream &input,
+    const IntRegion &region,
+    ThreadPool &threadPool)
+{
+    return detail::ToPlanar<count, options>(
+        DecodeImagePlanes(input, region, threadPool));
+}
+
+
+} // end namespace tau
@@ -0,0 +1,129 @@
+#pragma once
+
+
+#include <array>
+#include <cstddef>
+
+#include "tau/eigen.h"
+
+
+namespace tau
+{
+
+
+/**
+ ** Copies between separate planes and a buffer with the samples of each
+ ** pixel adjacent, as camera and display buffers are stored.
+ **
+ ** The 3 and 4 channel loops name each channel explicitly, so optimizing
+ ** compilers turn them into vector loads and shuffles.
+ **/
+
+
+// destination must hold count * pixelCount samples.
+template<size_t count, typename T>
+void Interleave(
+    const std::array<const T *, count> &planes,
+    T *destination,
+    Eigen::Index pixelCount)
+{
+    if constexpr (count == 3)
+    {
+        const T *first = planes[0];
+        const T *second = planes[1];
+        const T *third = planes[2];
+
+        for (Eigen::Index i = 0; i < pixelCount; ++i)
+        {
+            destination[3 * i] = first[i];
+            destination[3 * i + 1] = second[i];
+            destination[3 * i + 2] = third[i];
+        }
+    }
+    else if constexpr (count == 4)
+    {
+        const T *first = planes[0];
+        const T *second = planes[1];
+        const T *third = planes[2];
+        const T *fourth = planes[3];
+
+        for (Eigen::Index i = 0; i < pixelCount; ++i)
+        {
+            destination[4 * i] = first[i];
+            destination[4 * i + 1] = second[i];
+            destination[4 * i + 2] = third[i];
+            destination[4 * i + 3] = fourth[i];
+        }
+    }
+    else
+    {
+        static constexpr auto stride = static_cast<Eigen::Index>(count);
+
+        for (size_t plane = 0; plane < count; ++plane)
+        {
+            const T *source = planes[plane];
+            T *target = destination + plane;
+
+            for (Eigen::Index i = 0; i < pixelCount; ++i)
+            {
+                target[stride * i] = source[i];
+            }
+        }
+    }
+}
+
+
+// source must hold count * pixelCount samples.
+template<size_t count, typename T>
+void Deinterleave(
+    const T *source,
+    const std::array<T *, count> &planes,
+    Eigen::Index pixelCount)
+{
+    if constexpr (count == 3)
+    {
+        T *first = planes[0];
+        T *second = planes[1];
+        T *third = planes[2];
+
+        for (Eigen::Index i = 0; i < pixelCount; ++i)
+        {
+            first[i] = source[3 * i];
+            second[i] = source[3 * i + 1];
+            third[i] = source[3 * i + 2];
+        }
+    }
+    else if constexpr (count == 4)
+    {
+        T *first = planes[0];
+        T *second = planes[1];
+        T *third = planes[2];
+        T *fourth = planes[3];
+
+        for (Eigen::Index i = 0; i < pixelCount; ++i)
+        {
+            first[i] = source[4 * i];
+            second[i] = source[4 * i + 1];
+            third[i] = source[4 * i + 2];
+            fourth[i] = source[4 * i + 3];
+        }
+    }
+    else
+    {
+        static constexpr auto stride = static_cast<Eigen::Index>(count);
+
+        for (size_t plane = 0; plane < count; ++plane)
+        {
+            const T *channel = source + plane;
+            T *target = planes[plane];
+
+            for (Eigen::Index i = 0; i < pixelCount; ++i)
+            {
+                target[i] = channel[stride * i];
+            }
+        }
+    }
+}
+
+
+} // end namespace tau
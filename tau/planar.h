@@ -3,6 +3,7 @@
 #include <jive/power.h>
 #include <jive/range.h>
 #include "tau/eigen.h"
+#include "tau/interleave.h"
 #include "tau/size.h"
 
 
@@ -288,6 +289,18 @@ public:
 
         Planar result(rowCount, columnCount);
 
+        if constexpr (
+            std::is_base_of_v<Eigen::PlainObjectBase<Derived>, Derived>)
+        {
+            // The channels of each pixel are adjacent in memory.
+            if (channelsInColumns == static_cast<bool>(Derived::IsRowMajor))
+            {
+                result.ReadInterleaved(interleaved.derived().data());
+
+                return result;
+            }
+        }
+
         if (channelsInColumns)
         {
             for (Index i = 0; i < channelCount; ++i)
@@ -350,11 +363,49 @@ public:
             result = Result(size, count);
         }
 
-        this->Interleave_(result, std::make_index_sequence<count>{});
+        // Either shape stores the channels of each pixel together.
+        this->WriteInterleaved(result.data());
 
         return result;
     }
 
+    /**
+     ** Writes the samples of each pixel together, with pixels in the storage
+     ** order of the planes. destination must hold count samples for each
+     ** pixel.
+     **/
+    void WriteInterleaved(T *destination) const
+    {
+        std::array<const T *, count> sources;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            sources[i] = this->planes[i].data();
+        }
+
+        Interleave<count>(
+            sources,
+            destination,
+            std::get<0>(this->planes).size());
+    }
+
+    // Reads the layout written by WriteInterleaved into planes that have
+    // already been sized.
+    void ReadInterleaved(const T *source)
+    {
+        std::array<T *, count> targets;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            targets[i] = this->planes[i].data();
+        }
+
+        Deinterleave<count>(
+            source,
+            targets,
+            std::get<0>(this->planes).size());
+    }
+
     template<typename U>
     auto Cast() const
     {
@@ -638,35 +689,6 @@ private:
         (this->template ConstrainPlane<I>(minimum, maximum), ...);
     }
 
-    template<typename Result, size_t...I>
-    void Interleave_(Result &result, std::index_sequence<I...>) const
-    {
-        using Traits = MatrixTraits<Result>;
-
-        auto size = std::get<0>(this->planes).size();
-
-        if constexpr (Traits::isColumnMajor)
-        {
-            assert(result.rows() == count);
-            assert(result.cols() == size);
-
-            Fill(
-                result,
-                std::get<I>(this->planes)
-                    .template reshaped<Eigen::AutoOrder>(1, size)...);
-        }
-        else
-        {
-            assert(result.rows() == size);
-            assert(result.cols() == count);
-
-            Fill(
-                result,
-                std::get<I>(this->planes)
-                    .template reshaped<Eigen::AutoOrder>(size, 1)...);
-        }
-    }
-
     template<typename Result, size_t...I>
     void GetVector_(
         Result &result,
@@ -0,0 +1,326 @@
+#pragma once
+
+
+#include <memory>
+#include <new>
+
+#include "tau/planar.h"
+
+
+namespace tau
+{
+
+
+/**
+ ** Planes stored in one block of memory, each starting planeStride samples
+ ** after the one before it.
+ **
+ ** PlanarView does not own the memory, so it can wrap a buffer filled by a
+ ** device or by I/O without copying. Use a const T to wrap read-only
+ ** buffers. Every plane shares the storage order in options.
+ **/
+template<size_t count_, typename T, int options_ = Eigen::ColMajor>
+class PlanarView
+{
+public:
+    static constexpr auto count = count_;
+    using Type = std::remove_const_t<T>;
+    static constexpr auto rows = Eigen::Dynamic;
+    static constexpr auto columns = Eigen::Dynamic;
+    static constexpr auto options = options_;
+
+    using Index = Eigen::Index;
+    using Plain = Eigen::Matrix<Type, rows, columns, options>;
+
+    using Matrix = Eigen::Map
+    <
+        std::conditional_t<std::is_const_v<T>, const Plain, Plain>
+    >;
+
+    // The owning Planar that matches this view.
+    using PlanarType = Planar<count, Type, rows, columns, options>;
+
+    using Extrema = Planar<2, Type, rows, columns, options>;
+    using ExtremaIndices = Planar<2, Index, rows, columns, options>;
+
+    std::array<Matrix, count> planes;
+
+    PlanarView(T *data, Index rowCount, Index columnCount)
+        :
+        PlanarView(data, rowCount, columnCount, rowCount * columnCount)
+    {
+
+    }
+
+    PlanarView(
+        T *data,
+        Index rowCount,
+        Index columnCount,
+        Index planeStride)
+        :
+        planes(
+            MakePlanes_(
+                data,
+                rowCount,
+                columnCount,
+                planeStride,
+                std::make_index_sequence<count>{})),
+        planeStride_(planeStride)
+    {
+        if (planeStride < rowCount * columnCount)
+        {
+            throw PlanarError("planeStride is shorter than a plane");
+        }
+    }
+
+    Index GetRowCount() const
+    {
+        return std::get<0>(this->planes).rows();
+    }
+
+    Index GetColumnCount() const
+    {
+        return std::get<0>(this->planes).cols();
+    }
+
+    Size<Index> GetSize() const
+    {
+        return {{this->GetColumnCount(), this->GetRowCount()}};
+    }
+
+    Index GetPlaneStride() const
+    {
+        return this->planeStride_;
+    }
+
+    Eigen::Vector<Type, int(count)> GetVector(Index row, Index column) const
+    {
+        Eigen::Vector<Type, int(count)> result;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            result(Index(i)) = this->planes[i](row, column);
+        }
+
+        return result;
+    }
+
+    Extrema GetExtrema(ExtremaIndices *indices = nullptr) const
+    {
+        return this->GetExtrema(std::make_index_sequence<count>(), indices);
+    }
+
+    /**
+     ** As Planar::GetExtrema, the indices are positions in planeIndices.
+     ** Pixels are visited in storage order, which every plane shares.
+     **/
+    template<size_t...I>
+    Extrema GetExtrema(
+        std::index_sequence<I...>,
+        ExtremaIndices *indices = nullptr) const
+    {
+        Extrema result(this->GetRowCount(), this->GetColumnCount());
+
+        std::array<const Type *, sizeof...(I)> sources{
+            std::get<I>(this->planes).data()...};
+
+        Type *minima = result.planes[0].data();
+        Type *maxima = result.planes[1].data();
+        Index pixelCount = std::get<0>(this->planes).size();
+
+        Eigen::Vector<Type, int(sizeof...(I))> coreSample;
+
+        for (Index pixel = 0; pixel < pixelCount; ++pixel)
+        {
+            for (size_t i = 0; i < sources.size(); ++i)
+            {
+                coreSample(Index(i)) = sources[i][pixel];
+            }
+
+            if (indices)
+            {
+                minima[pixel] =
+                    coreSample.minCoeff(&indices->planes[0].data()[pixel]);
+
+                maxima[pixel] =
+                    coreSample.maxCoeff(&indices->planes[1].data()[pixel]);
+            }
+            else
+            {
+                minima[pixel] = coreSample.minCoeff();
+                maxima[pixel] = coreSample.maxCoeff();
+            }
+        }
+
+        return result;
+    }
+
+    template<typename U>
+    Planar<count, U, rows, columns, options> Cast() const
+    {
+        Planar<count, U, rows, columns, options> result;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            result.planes[i] = this->planes[i].template cast<U>();
+        }
+
+        return result;
+    }
+
+    PlanarType ToPlanar() const
+    {
+        return this->template Cast<Type>();
+    }
+
+    // Copies planar, which must have the same size, into the viewed memory.
+    template<int rows_, int columns_>
+    void Assign(const Planar<count, Type, rows_, columns_, options> &planar)
+    {
+        static_assert(!std::is_const_v<T>, "Cannot assign to a const view");
+
+        if (
+            planar.GetRowCount() != this->GetRowCount()
+            || planar.GetColumnCount() != this->GetColumnCount())
+        {
+            throw PlanarError("Cannot assign planes of a different size");
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            this->planes[i] = planar.planes[i];
+        }
+    }
+
+private:
+    template<size_t...I>
+    static std::array<Matrix, count> MakePlanes_(
+        T *data,
+        Index rowCount,
+        Index columnCount,
+        Index planeStride,
+        std::index_sequence<I...>)
+    {
+        return {
+            Matrix(
+                data + static_cast<Index>(I) * planeStride,
+                rowCount,
+                columnCount)...};
+    }
+
+    Index planeStride_;
+};
+
+
+template<size_t count_, typename T, int options_>
+struct IsPlanar_<PlanarView<count_, T, options_>>
+    :
+    std::true_type
+{
+
+};
+
+
+/**
+ ** Owns the memory for a PlanarView in a single allocation.
+ **
+ ** The default plane stride rounds each plane up to planeAlignment bytes, so
+ ** every plane starts on a cache line. The samples are not initialized, so
+ ** the buffer can be handed directly to a device or to I/O.
+ **/
+template<size_t count, typename T, int options = Eigen::ColMajor>
+class ContiguousPlanar
+{
+public:
+    static_assert(std::is_trivial_v<T>);
+
+    using Index = Eigen::Index;
+    using View = PlanarView<count, T, options>;
+    using ConstView = PlanarView<count, const T, options>;
+
+    static constexpr size_t planeAlignment = 64;
+
+    ContiguousPlanar(Index rowCount, Index columnCount)
+        :
+        ContiguousPlanar(
+            rowCount,
+            columnCount,
+            GetAlignedStride(rowCount * columnCount))
+    {
+
+    }
+
+    ContiguousPlanar(Index rowCount, Index columnCount, Index planeStride)
+        :
+        data_(Allocate_(static_cast<size_t>(planeStride) * count)),
+        view_(this->data_.get(), rowCount, columnCount, planeStride)
+    {
+
+    }
+
+    // The smallest stride of at least pixelCount that keeps the start of each
+    // plane aligned.
+    static Index GetAlignedStride(Index pixelCount)
+    {
+        static constexpr auto samplesPerLine = static_cast<Index>(
+            std::max(planeAlignment / sizeof(T), size_t{1}));
+
+        return samplesPerLine
+            * ((pixelCount + samplesPerLine - 1) / samplesPerLine);
+    }
+
+    T * GetData()
+    {
+        return this->data_.get();
+    }
+
+    const T * GetData() const
+    {
+        return this->data_.get();
+    }
+
+    // The size of the single allocation.
+    size_t GetByteCount() const
+    {
+        return sizeof(T) * count
+            * static_cast<size_t>(this->view_.GetPlaneStride());
+    }
+
+    View & GetView()
+    {
+        return this->view_;
+    }
+
+    ConstView GetView() const
+    {
+        return ConstView(
+            this->data_.get(),
+            this->view_.GetRowCount(),
+            this->view_.GetColumnCount(),
+            this->view_.GetPlaneStride());
+    }
+
+private:
+    struct Delete_
+    {
+        void operator()(T *data) const
+        {
+            ::operator delete[](data, std::align_val_t{planeAlignment});
+        }
+    };
+
+    static std::unique_ptr<T[], Delete_> Allocate_(size_t sampleCount)
+    {
+        return std::unique_ptr<T[], Delete_>(
+            static_cast<T *>(
+                ::operator new[](
+                    sampleCount * sizeof(T),
+                    std::align_val_t{planeAlignment})));
+    }
+
+    std::unique_ptr<T[], Delete_> data_;
+    View view_;
+};
+
+
+} // end namespace tau
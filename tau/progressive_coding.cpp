@@ -0,0 +1,689 @@
+#include "tau/progressive_coding.h"
+
+#include <cmath>
+#include <iterator>
+#include <sstream>
+#include <jive/binary_io.h>
+#include <fmt/core.h>
+
+#include "tau/wavelet_compression.h"
+
+
+namespace tau
+{
+
+
+namespace detail
+{
+
+
+/**
+ ** The parent-child relationships between coefficients, with every row
+ ** flattened into a single index space.
+ **/
+class CoefficientTree
+{
+public:
+    CoefficientTree(const std::vector<size_t> &rowLengths)
+        :
+        firstChild_(),
+        childCount_(),
+        roots_()
+    {
+        size_t rowCount = rowLengths.size();
+        size_t rowOffset = 0;
+
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            size_t length = rowLengths[row];
+            size_t nextOffset = rowOffset + length;
+
+            // Coefficients not covered by a parent in the previous row are
+            // roots. For row 0, that is all of them.
+            size_t parentedCount = 0;
+
+            if (row == 1)
+            {
+                parentedCount = rowLengths[0];
+            }
+            else if (row > 1)
+            {
+                parentedCount = 2 * rowLengths[row - 1];
+            }
+
+            for (size_t i = parentedCount; i < length; ++i)
+            {
+                this->roots_.push_back(rowOffset + i);
+            }
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                size_t begin = 0;
+                size_t end = 0;
+
+                if (row + 1 < rowCount)
+                {
+                    size_t nextLength = rowLengths[row + 1];
+
+                    if (row == 0)
+                    {
+                        begin = i;
+                        end = std::min(i + 1, nextLength);
+                    }
+                    else
+                    {
+                        begin = 2 * i;
+                        end = std::min(2 * i + 2, nextLength);
+                    }
+
+                    end = std::max(begin, end);
+                }
+
+                this->firstChild_.push_back(nextOffset + begin);
+                this->childCount_.push_back(static_cast<uint8_t>(end - begin));
+            }
+
+            rowOffset = nextOffset;
+        }
+    }
+
+    size_t GetSize() const
+    {
+        return this->firstChild_.size();
+    }
+
+    const std::vector<size_t> & GetRoots() const
+    {
+        return this->roots_;
+    }
+
+    size_t GetFirstChild(size_t node) const
+    {
+        return this->firstChild_[node];
+    }
+
+    size_t GetChildEnd(size_t node) const
+    {
+        return this->firstChild_[node] + this->childCount_[node];
+    }
+
+    bool HasChildren(size_t node) const
+    {
+        return this->childCount_[node] > 0;
+    }
+
+    bool HasGrandchildren(size_t node) const
+    {
+        for (
+            size_t child = this->GetFirstChild(node);
+            child < this->GetChildEnd(node);
+            ++child)
+        {
+            if (this->HasChildren(child))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    std::vector<size_t> firstChild_;
+    std::vector<uint8_t> childCount_;
+    std::vector<size_t> roots_;
+};
+
+
+// Thrown when the bit budget is spent, or the truncated input runs out.
+struct Exhausted {};
+
+
+class BitWriter
+{
+public:
+    BitWriter(size_t maximumBitCount)
+        :
+        bytes_(),
+        bitCount_(0),
+        maximumBitCount_(maximumBitCount)
+    {
+
+    }
+
+    void Write(bool bit)
+    {
+        if (this->bitCount_ >= this->maximumBitCount_)
+        {
+            throw Exhausted{};
+        }
+
+        if (this->bitCount_ % 8 == 0)
+        {
+            this->bytes_.push_back('\0');
+        }
+
+        if (bit)
+        {
+            this->bytes_.back() = static_cast<char>(
+                static_cast<uint8_t>(this->bytes_.back())
+                    | (0x80u >> (this->bitCount_ % 8)));
+        }
+
+        ++this->bitCount_;
+    }
+
+    const std::string & GetBytes() const
+    {
+        return this->bytes_;
+    }
+
+private:
+    std::string bytes_;
+    size_t bitCount_;
+    size_t maximumBitCount_;
+};
+
+
+class BitReader
+{
+public:
+    BitReader(std::string bytes)
+        :
+        bytes_(std::move(bytes)),
+        bitIndex_(0)
+    {
+
+    }
+
+    bool Read()
+    {
+        if (this->bitIndex_ >= this->bytes_.size() * 8)
+        {
+            throw Exhausted{};
+        }
+
+        auto byte = static_cast<uint8_t>(this->bytes_[this->bitIndex_ / 8]);
+        bool result = byte & (0x80u >> (this->bitIndex_ % 8));
+        ++this->bitIndex_;
+
+        return result;
+    }
+
+private:
+    std::string bytes_;
+    size_t bitIndex_;
+};
+
+
+class SpihtEncoder
+{
+public:
+    SpihtEncoder(
+        const CoefficientTree &tree,
+        const std::vector<double> &values,
+        BitWriter &writer)
+        :
+        magnitudes_(values.size()),
+        negative_(values.size()),
+        descendantMaxima_(values.size(), 0.0),
+        grandDescendantMaxima_(values.size(), 0.0),
+        writer_(writer)
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            this->magnitudes_[i] = std::abs(values[i]);
+            this->negative_[i] = std::signbit(values[i]);
+        }
+
+        // Children always follow their parents in the flattened index space,
+        // so a reverse sweep visits every child before its parent.
+        for (size_t node = tree.GetSize(); node-- > 0;)
+        {
+            double descendants = 0.0;
+            double grandDescendants = 0.0;
+
+            for (
+                size_t child = tree.GetFirstChild(node);
+                child < tree.GetChildEnd(node);
+                ++child)
+            {
+                descendants = std::max(
+                    {
+                        descendants,
+                        this->magnitudes_[child],
+                        this->descendantMaxima_[child]});
+
+                grandDescendants =
+                    std::max(grandDescendants, this->descendantMaxima_[child]);
+            }
+
+            this->descendantMaxima_[node] = descendants;
+            this->grandDescendantMaxima_[node] = grandDescendants;
+        }
+    }
+
+    bool Significance(size_t node, double threshold)
+    {
+        return this->Emit_(this->magnitudes_[node] >= threshold);
+    }
+
+    bool DescendantSignificance(size_t node, double threshold)
+    {
+        return this->Emit_(this->descendantMaxima_[node] >= threshold);
+    }
+
+    bool GrandDescendantSignificance(size_t node, double threshold)
+    {
+        return this->Emit_(this->grandDescendantMaxima_[node] >= threshold);
+    }
+
+    void Sign(size_t node, double)
+    {
+        this->writer_.Write(this->negative_[node]);
+    }
+
+    void Refine(size_t node, double threshold)
+    {
+        // threshold is a power of two, so the division is exact.
+        double bitPlane = std::floor(this->magnitudes_[node] / threshold);
+        this->writer_.Write(std::fmod(bitPlane, 2.0) == 1.0);
+    }
+
+private:
+    bool Emit_(bool bit)
+    {
+        this->writer_.Write(bit);
+
+        return bit;
+    }
+
+private:
+    std::vector<double> magnitudes_;
+    std::vector<bool> negative_;
+    std::vector<double> descendantMaxima_;
+    std::vector<double> grandDescendantMaxima_;
+    BitWriter &writer_;
+};
+
+
+class SpihtDecoder
+{
+public:
+    SpihtDecoder(size_t size, BitReader &reader)
+        :
+        values_(size, 0.0),
+        reader_(reader)
+    {
+
+    }
+
+    bool Significance(size_t, double)
+    {
+        return this->reader_.Read();
+    }
+
+    bool DescendantSignificance(size_t, double)
+    {
+        return this->reader_.Read();
+    }
+
+    bool GrandDescendantSignificance(size_t, double)
+    {
+        return this->reader_.Read();
+    }
+
+    void Sign(size_t node, double threshold)
+    {
+        bool isNegative = this->reader_.Read();
+
+        // The coefficient is somewhere in [threshold, 2 * threshold).
+        this->values_[node] = 1.5 * threshold;
+
+        if (isNegative)
+        {
+            this->values_[node] = -this->values_[node];
+        }
+    }
+
+    void Refine(size_t node, double threshold)
+    {
+        double step = (this->reader_.Read()) ? threshold / 2 : -threshold / 2;
+
+        if (this->values_[node] < 0)
+        {
+            step = -step;
+        }
+
+        this->values_[node] += step;
+    }
+
+    const std::vector<double> & GetValues() const
+    {
+        return this->values_;
+    }
+
+private:
+    std::vector<double> values_;
+    BitReader &reader_;
+};
+
+
+/**
+ ** The sorting and refinement passes shared by the encoder and the decoder.
+ **
+ ** The encoder answers each question from the coefficients and records the
+ ** answer. The decoder reads the answer back, so both sides make identical
+ ** decisions about the lists.
+ **/
+template<typename Coder>
+void RunPasses(
+    const CoefficientTree &tree,
+    Coder &coder,
+    int topBitPlane,
+    int minimumBitPlane)
+{
+    struct SetEntry
+    {
+        size_t node;
+
+        // Type A sets hold all descendants of node.
+        // Type B sets hold all descendants except the children.
+        bool isTypeB;
+    };
+
+    // Insignificant pixels, significant pixels, and insignificant sets.
+    std::vector<size_t> insignificant = tree.GetRoots();
+    std::vector<size_t> significant;
+    std::vector<SetEntry> sets;
+
+    for (auto root: tree.GetRoots())
+    {
+        if (tree.HasChildren(root))
+        {
+            sets.push_back({root, false});
+        }
+    }
+
+    for (int bitPlane = topBitPlane; bitPlane >= minimumBitPlane; --bitPlane)
+    {
+        double threshold = std::ldexp(1.0, bitPlane);
+
+        // Coefficients that become significant during this pass are not
+        // refined until the next one.
+        size_t refineCount = significant.size();
+
+        size_t kept = 0;
+
+        for (auto node: insignificant)
+        {
+            if (coder.Significance(node, threshold))
+            {
+                coder.Sign(node, threshold);
+                significant.push_back(node);
+            }
+            else
+            {
+                insignificant[kept++] = node;
+            }
+        }
+
+        insignificant.resize(kept);
+
+        // Entries appended to sets are processed in this same pass.
+        std::vector<SetEntry> remaining;
+
+        for (size_t i = 0; i < sets.size(); ++i)
+        {
+            SetEntry entry = sets[i];
+            size_t node = entry.node;
+
+            if (!entry.isTypeB)
+            {
+                if (!coder.DescendantSignificance(node, threshold))
+                {
+                    remaining.push_back(entry);
+                    continue;
+                }
+
+                for (
+                    size_t child = tree.GetFirstChild(node);
+                    child < tree.GetChildEnd(node);
+                    ++child)
+                {
+                    if (coder.Significance(child, threshold))
+                    {
+                        coder.Sign(child, threshold);
+                        significant.push_back(child);
+                    }
+                    else
+                    {
+                        insignificant.push_back(child);
+                    }
+                }
+
+                if (tree.HasGrandchildren(node))
+                {
+                    sets.push_back({node, true});
+                }
+            }
+            else
+            {
+                if (!coder.GrandDescendantSignificance(node, threshold))
+                {
+                    remaining.push_back(entry);
+                    continue;
+                }
+
+                for (
+                    size_t child = tree.GetFirstChild(node);
+                    child < tree.GetChildEnd(node);
+                    ++child)
+                {
+                    if (tree.HasChildren(child))
+                    {
+                        sets.push_back({child, false});
+                    }
+                }
+            }
+        }
+
+        sets = std::move(remaining);
+
+        for (size_t i = 0; i < refineCount; ++i)
+        {
+            coder.Refine(significant[i], threshold);
+        }
+    }
+}
+
+
+std::vector<size_t> GetRowLengths(const Decomposed<double> &decomposed)
+{
+    std::vector<size_t> result;
+
+    for (auto &row: decomposed)
+    {
+        result.push_back(static_cast<size_t>(row.size()));
+    }
+
+    return result;
+}
+
+
+int8_t ToBitPlane(int bitPlane)
+{
+    if (
+        bitPlane < std::numeric_limits<int8_t>::min()
+        || bitPlane > std::numeric_limits<int8_t>::max())
+    {
+        throw std::out_of_range(
+            fmt::format("Bit-plane out of range: {}", bitPlane));
+    }
+
+    return static_cast<int8_t>(bitPlane);
+}
+
+
+} // end namespace detail
+
+
+void EncodeProgressive(
+    std::ostream &output,
+    const Decomposed<double> &decomposed,
+    int minimumBitPlane,
+    size_t maximumByteCount)
+{
+    auto rowLengths = detail::GetRowLengths(decomposed);
+    detail::CoefficientTree tree(rowLengths);
+
+    std::vector<double> values;
+    values.reserve(tree.GetSize());
+    double maximum = 0.0;
+
+    for (auto &row: decomposed)
+    {
+        for (auto value: row)
+        {
+            values.push_back(value);
+            maximum = std::max(maximum, std::abs(value));
+        }
+    }
+
+    // Without any significant coefficients, there are no passes to run.
+    int topBitPlane = minimumBitPlane - 1;
+
+    if (maximum > 0.0)
+    {
+        topBitPlane = std::max(
+            topBitPlane,
+            static_cast<int>(std::floor(std::log2(maximum))));
+    }
+
+    std::ostringstream header;
+
+    for (auto byte: progressive::magic)
+    {
+        jive::io::Write(header, byte);
+    }
+
+    jive::io::Write(header, progressive::version);
+    WriteVarint(header, rowLengths.size());
+
+    for (auto length: rowLengths)
+    {
+        WriteVarint(header, length);
+    }
+
+    jive::io::Write(header, detail::ToBitPlane(topBitPlane));
+    jive::io::Write(header, detail::ToBitPlane(minimumBitPlane));
+
+    auto headerBytes = header.str();
+
+    if (headerBytes.size() > maximumByteCount)
+    {
+        throw std::invalid_argument(
+            "maximumByteCount does not leave room for the header.");
+    }
+
+    size_t maximumBitCount = std::numeric_limits<size_t>::max();
+
+    if (maximumByteCount - headerBytes.size() < maximumBitCount / 8)
+    {
+        maximumBitCount = (maximumByteCount - headerBytes.size()) * 8;
+    }
+
+    detail::BitWriter writer(maximumBitCount);
+    detail::SpihtEncoder encoder(tree, values, writer);
+
+    try
+    {
+        detail::RunPasses(tree, encoder, topBitPlane, minimumBitPlane);
+    }
+    catch (detail::Exhausted &)
+    {
+        // The byte budget is spent.
+    }
+
+    output.write(
+        headerBytes.data(),
+        static_cast<std::streamsize>(headerBytes.size()));
+
+    auto &bits = writer.GetBytes();
+    output.write(bits.data(), static_cast<std::streamsize>(bits.size()));
+}
+
+
+Decomposed<double> DecodeProgressive(std::istream &input)
+{
+    for (auto byte: progressive::magic)
+    {
+        if (jive::io::Read<uint8_t>(input) != byte)
+        {
+            throw std::runtime_error("Bad magic");
+        }
+    }
+
+    auto version = jive::io::Read<uint8_t>(input);
+
+    if (version != progressive::version)
+    {
+        throw std::runtime_error(
+            fmt::format("Unsupported version: {}", version));
+    }
+
+    auto rowCount = ReadVarint(input);
+    std::vector<size_t> rowLengths;
+
+    for (uint64_t i = 0; i < rowCount; ++i)
+    {
+        rowLengths.push_back(ReadVarint(input));
+    }
+
+    int topBitPlane = jive::io::Read<int8_t>(input);
+    int minimumBitPlane = jive::io::Read<int8_t>(input);
+
+    if (!input.good())
+    {
+        throw std::runtime_error("input is not good");
+    }
+
+    detail::CoefficientTree tree(rowLengths);
+
+    detail::BitReader reader(
+        std::string(std::istreambuf_iterator<char>(input), {}));
+
+    detail::SpihtDecoder decoder(tree.GetSize(), reader);
+
+    try
+    {
+        detail::RunPasses(tree, decoder, topBitPlane, minimumBitPlane);
+    }
+    catch (detail::Exhausted &)
+    {
+        // A truncated stream leaves the coarser approximation in place.
+    }
+
+    auto &values = decoder.GetValues();
+    Decomposed<double> result;
+    size_t offset = 0;
+
+    for (auto length: rowLengths)
+    {
+        Eigen::RowVector<double, Eigen::Dynamic> row(
+            static_cast<Eigen::Index>(length));
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            row(static_cast<Eigen::Index>(i)) = values[offset + i];
+        }
+
+        result.push_back(row);
+        offset += length;
+    }
+
+    return result;
+}
+
+
+} // end namespace tau
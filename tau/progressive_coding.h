@@ -0,0 +1,70 @@
+#pragma once
+
+
+#include <array>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+#include "tau/wavelet.h"
+
+
+namespace tau
+{
+
+
+/**
+ ** Embedded bit-plane coding of wavelet coefficients (SPIHT).
+ **
+ ** Coefficients are sent from the most significant bit-plane down, so every
+ ** prefix of the stream decodes to the best approximation available at that
+ ** size. A stream can be written once at full quality, and lower quality
+ ** tiers are served by truncating it.
+ **
+ ** The coefficients form a tree across levels. Each approximation
+ ** coefficient is the parent of the detail coefficient at the same position
+ ** in the coarsest detail row, and each detail coefficient i is the parent of
+ ** coefficients 2i and 2i + 1 in the next finer row. Because the magnitudes of
+ ** smooth signals decay toward the finer rows, a single bit often marks a
+ ** whole subtree as insignificant.
+ **
+ ** Layout:
+ **
+ **     magic (4 bytes) | version (1 byte) | row count (varint)
+ **     | row lengths (varint each) | top bit-plane (int8)
+ **     | minimum bit-plane (int8) | bits, most significant first
+ **
+ ** The bits run to the end of the stream.
+ **/
+namespace progressive
+{
+
+inline constexpr std::array<uint8_t, 4> magic{0xFF, 'T', 'W', 'P'};
+inline constexpr uint8_t version = 1;
+
+} // end namespace progressive
+
+
+/**
+ ** minimumBitPlane sets the finest precision coded. Coefficients are
+ ** recovered to within 2^(minimumBitPlane - 1), and coefficients smaller than
+ ** 2^minimumBitPlane are not coded at all. Use a negative value for
+ ** fractional precision.
+ **
+ ** Coding stops early when the stream reaches maximumByteCount.
+ **/
+void EncodeProgressive(
+    std::ostream &output,
+    const Decomposed<double> &decomposed,
+    int minimumBitPlane = 0,
+    size_t maximumByteCount = std::numeric_limits<size_t>::max());
+
+
+/**
+ ** Reads to the end of input. Any prefix of a stream that includes the header
+ ** can be decoded.
+ **/
+Decomposed<double> DecodeProgressive(std::istream &input);
+
+
+} // end namespace tau
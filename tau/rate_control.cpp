@@ -0,0 +1,234 @@
+#include "tau/rate_control.h"
+
+
+namespace tau
+{
+
+
+RateEstimate EstimateRate(
+    const Decomposed<double> &decomposed,
+    double threshold,
+    Eigen::Index signalLength,
+    bool enableMultibyteZeros)
+{
+    // Matches Quantize.
+    double quantize = std::max(std::round(threshold), 1.0);
+
+    size_t byteCount = format::magic.size() + 2;
+    byteCount += GetVarintSize(decomposed.size());
+
+    double squaredError = 0.0;
+
+    for (auto &row: decomposed)
+    {
+        byteCount += GetVarintSize(static_cast<uint64_t>(row.size()));
+
+        size_t zeroCount = 0;
+
+        for (auto value: row)
+        {
+            double quantized = 0.0;
+
+            if (std::abs(value) >= threshold)
+            {
+                quantized = std::round(value / quantize);
+            }
+
+            double error = value - quantized * quantize;
+            squaredError += error * error;
+
+            if (quantized == 0.0)
+            {
+                ++zeroCount;
+                continue;
+            }
+
+            if (zeroCount)
+            {
+                byteCount += GetZeroRunSize(zeroCount, enableMultibyteZeros);
+                zeroCount = 0;
+            }
+
+            byteCount += GetValueSize(static_cast<int64_t>(quantized));
+        }
+
+        byteCount += GetZeroRunSize(zeroCount, enableMultibyteZeros);
+    }
+
+    return {
+        threshold,
+        quantize,
+        byteCount,
+        std::sqrt(squaredError / static_cast<double>(signalLength))};
+}
+
+
+RateControlSettings RateControlSettings::Default()
+{
+    return {true, 1e-3, 64};
+}
+
+
+namespace detail
+{
+
+
+double GetMaximumMagnitude(const Decomposed<double> &decomposed)
+{
+    double result = 0.0;
+
+    for (auto &row: decomposed)
+    {
+        if (row.size())
+        {
+            result = std::max(result, row.array().abs().maxCoeff());
+        }
+    }
+
+    return result;
+}
+
+
+/**
+ ** Bisect between a threshold that meets the target and one that does not.
+ ** Returns the estimate for the final threshold that meets the target.
+ **/
+template<typename Meets>
+RateEstimate Bisect(
+    RateEstimate meets,
+    RateEstimate fails,
+    const RateControlSettings &settings,
+    Meets &&meetsTarget,
+    const Decomposed<double> &decomposed,
+    Eigen::Index signalLength)
+{
+    for (size_t i = 0; i < settings.maximumIterations; ++i)
+    {
+        double width = std::abs(fails.threshold - meets.threshold);
+
+        if (width <= settings.tolerance
+                * std::max(meets.threshold, fails.threshold))
+        {
+            break;
+        }
+
+        auto middle = EstimateRate(
+            decomposed,
+            (meets.threshold + fails.threshold) / 2.0,
+            signalLength,
+            settings.enableMultibyteZeros);
+
+        if (meetsTarget(middle))
+        {
+            meets = middle;
+        }
+        else
+        {
+            fails = middle;
+        }
+    }
+
+    return meets;
+}
+
+
+} // end namespace detail
+
+
+RateEstimate FindThresholdForSize(
+    const Decomposed<double> &decomposed,
+    Eigen::Index signalLength,
+    size_t maximumByteCount,
+    const RateControlSettings &settings)
+{
+    auto meetsTarget = [maximumByteCount](const RateEstimate &estimate)
+    {
+        return estimate.byteCount <= maximumByteCount;
+    };
+
+    auto lowest = EstimateRate(
+        decomposed,
+        0.0,
+        signalLength,
+        settings.enableMultibyteZeros);
+
+    if (meetsTarget(lowest))
+    {
+        return lowest;
+    }
+
+    // Every coefficient is discarded above the maximum magnitude.
+    auto highest = EstimateRate(
+        decomposed,
+        detail::GetMaximumMagnitude(decomposed) + 1.0,
+        signalLength,
+        settings.enableMultibyteZeros);
+
+    if (!meetsTarget(highest))
+    {
+        return highest;
+    }
+
+    return detail::Bisect(
+        highest,
+        lowest,
+        settings,
+        meetsTarget,
+        decomposed,
+        signalLength);
+}
+
+
+RateEstimate FindThresholdForRms(
+    const Decomposed<double> &decomposed,
+    Eigen::Index signalLength,
+    double maximumRms,
+    const RateControlSettings &settings)
+{
+    auto meetsTarget = [maximumRms](const RateEstimate &estimate)
+    {
+        return estimate.rms <= maximumRms;
+    };
+
+    auto highest = EstimateRate(
+        decomposed,
+        detail::GetMaximumMagnitude(decomposed) + 1.0,
+        signalLength,
+        settings.enableMultibyteZeros);
+
+    if (meetsTarget(highest))
+    {
+        return highest;
+    }
+
+    auto lowest = EstimateRate(
+        decomposed,
+        0.0,
+        signalLength,
+        settings.enableMultibyteZeros);
+
+    if (!meetsTarget(lowest))
+    {
+        // Only the rounding error remains, and it is still too large.
+        return lowest;
+    }
+
+    return detail::Bisect(
+        lowest,
+        highest,
+        settings,
+        meetsTarget,
+        decomposed,
+        signalLength);
+}
+
+
+double ApplyRate(Decomposed<double> &decomposed, const RateEstimate &estimate)
+{
+    ZeroBelow(decomposed, estimate.threshold);
+
+    return Quantize(decomposed, estimate.threshold);
+}
+
+
+} // end namespace tau
@@ -0,0 +1,97 @@
+#pragma once
+
+
+#include "tau/wavelet_compression.h"
+
+
+namespace tau
+{
+
+
+/**
+ ** Rate control selects the threshold passed to ZeroBelow and Quantize.
+ **
+ ** Coefficients with magnitude below the threshold are discarded, and the
+ ** survivors are divided by the rounded threshold. Raising the threshold
+ ** lowers the encoded size and raises the error, so the threshold for a
+ ** target is found by bisection.
+ **
+ ** Each probe of the search makes one pass over the coefficients to gather
+ ** run lengths and value widths. Nothing is encoded or copied.
+ **/
+
+
+struct RateEstimate
+{
+    double threshold;
+    double quantize;
+
+    // The exact size of the stream Encode would produce.
+    size_t byteCount;
+
+    // The RMS error per signal sample, measured on the coefficients.
+    // The Daubechies wavelets are orthonormal, so by Parseval's theorem this
+    // matches the error of the recomposed signal, apart from small effects
+    // at the signal boundaries.
+    double rms;
+};
+
+
+RateEstimate EstimateRate(
+    const Decomposed<double> &decomposed,
+    double threshold,
+    Eigen::Index signalLength,
+    bool enableMultibyteZeros);
+
+
+struct RateControlSettings
+{
+    bool enableMultibyteZeros;
+
+    // Bisection stops when the threshold bracket is narrower than this
+    // fraction of the threshold.
+    double tolerance;
+
+    // Bound on the count of probes, whatever the tolerance.
+    size_t maximumIterations;
+
+    static RateControlSettings Default();
+};
+
+
+/**
+ ** Find the lowest threshold that encodes decomposed in no more than
+ ** maximumByteCount bytes.
+ **
+ ** When the budget cannot be met, the estimate for the largest useful
+ ** threshold is returned, and its byteCount exceeds the budget.
+ **/
+RateEstimate FindThresholdForSize(
+    const Decomposed<double> &decomposed,
+    Eigen::Index signalLength,
+    size_t maximumByteCount,
+    const RateControlSettings &settings = RateControlSettings::Default());
+
+
+/**
+ ** Find the highest threshold with an estimated RMS error no larger than
+ ** maximumRms.
+ **/
+RateEstimate FindThresholdForRms(
+    const Decomposed<double> &decomposed,
+    Eigen::Index signalLength,
+    double maximumRms,
+    const RateControlSettings &settings = RateControlSettings::Default());
+
+
+/**
+ ** Discard and quantize the coefficients using the threshold from an
+ ** estimate.
+ **
+ ** Returns the quantization factor, to be stored alongside the encoded
+ ** stream like the result of Quantize.
+ **/
+double ApplyRate(Decomposed<double> &decomposed, const RateEstimate &estimate);
+
+
+} // end namespace tau
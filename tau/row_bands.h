@@ -0,0 +1,72 @@
+#pragma once
+
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include "tau/eigen.h"
+#include "tau/thread_pool.h"
+
+
+namespace tau
+{
+
+
+/**
+ ** Calls mapBand(firstRow, rowCount) for bands of rows on threadPool, and
+ ** waits for every band before returning or rethrowing. There are no more
+ ** bands than threads, and bands are at least minimumRowCount rows, because
+ ** shorter bands cost more to schedule than to process.
+ **
+ ** Calling it from a job already running on threadPool can deadlock.
+ **/
+template<typename MapBand>
+void ForEachRowBand(
+    Eigen::Index rowCount,
+    ThreadPool &threadPool,
+    MapBand &&mapBand,
+    Eigen::Index minimumRowCount = 16)
+{
+    auto bandCount = std::clamp(
+        rowCount / std::max(minimumRowCount, Eigen::Index{1}),
+        Eigen::Index{1},
+        static_cast<Eigen::Index>(threadPool.GetThreadCount()));
+
+    if (bandCount == 1)
+    {
+        mapBand(Eigen::Index{0}, rowCount);
+
+        return;
+    }
+
+    std::vector<std::future<void>> bands;
+    bands.reserve(static_cast<size_t>(bandCount));
+
+    for (Eigen::Index band = 0; band < bandCount; ++band)
+    {
+        auto first = band * rowCount / bandCount;
+        auto next = (band + 1) * rowCount / bandCount;
+
+        bands.push_back(
+            threadPool.Submit(
+                [&mapBand, first, next]()
+                {
+                    mapBand(first, next - first);
+                }));
+    }
+
+    // Every band must finish before mapBand goes out of scope.
+    for (auto &band: bands)
+    {
+        band.wait();
+    }
+
+    for (auto &band: bands)
+    {
+        band.get();
+    }
+}
+
+
+} // end namespace tau
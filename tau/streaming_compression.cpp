@@ -0,0 +1,388 @@
+#include "tau/streaming_compression.h"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <jive/binary_io.h>
+
+
+namespace tau
+{
+
+
+StreamingSettings StreamingSettings::Default()
+{
+    return {WaveletName::db4, 0.1, true, false, 1024, 5};
+}
+
+
+namespace detail
+{
+
+
+using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+
+void AppendTo(RowVector &target, const RowVector &values)
+{
+    auto size = target.size();
+    target.conservativeResize(size + values.size());
+    target.tail(values.size()) = values;
+}
+
+
+// Prepends history to input.
+RowVector Join(const RowVector &history, const RowVector &input)
+{
+    RowVector result(history.size() + input.size());
+    result.head(history.size()) = history;
+    result.tail(input.size()) = input;
+
+    return result;
+}
+
+
+AnalysisStage::AnalysisStage(const WaveletFilter<double> &filter)
+    :
+    low_(filter.low.reverse()),
+    high_(filter.high.reverse()),
+    history_(RowVector::Zero(filter.low.size() - 2))
+{
+
+}
+
+
+void AnalysisStage::Process(
+    const RowVector &input,
+    RowVector &approximation,
+    RowVector &detail)
+{
+    assert(input.size() % 2 == 0);
+
+    using Eigen::Index;
+
+    Index filterLength = this->low_.size();
+    Index count = input.size() / 2;
+    RowVector combined = Join(this->history_, input);
+
+    Index start = approximation.size();
+    approximation.conservativeResize(start + count);
+    detail.conservativeResize(start + count);
+
+    // Each output is the filter at an odd position of the full convolution,
+    // as in Decompose.
+    for (Index i = 0; i < count; ++i)
+    {
+        auto segment = combined.segment(2 * i, filterLength);
+        approximation(start + i) = this->low_.dot(segment);
+        detail(start + i) = this->high_.dot(segment);
+    }
+
+    this->history_ = combined.tail(this->history_.size());
+}
+
+
+RowVector GetPhase(const RowVector &filter, Eigen::Index phase)
+{
+    auto count = filter.size() / 2;
+
+    return filter(Eigen::seqN(phase, count, 2)).reverse();
+}
+
+
+SynthesisStage::SynthesisStage(const WaveletFilter<double> &filter)
+    :
+    evenLow_(GetPhase(filter.low, 0)),
+    oddLow_(GetPhase(filter.low, 1)),
+    evenHigh_(GetPhase(filter.high, 0)),
+    oddHigh_(GetPhase(filter.high, 1)),
+    approximationHistory_(RowVector::Zero(filter.low.size() / 2 - 1)),
+    detailHistory_(RowVector::Zero(filter.low.size() / 2 - 1)),
+    discardCount_(filter.low.size() - 2)
+{
+
+}
+
+
+RowVector SynthesisStage::Process(
+    const RowVector &approximation,
+    const RowVector &detail)
+{
+    assert(approximation.size() == detail.size());
+
+    using Eigen::Index;
+
+    Index phaseLength = this->evenLow_.size();
+    Index count = approximation.size();
+
+    RowVector approximations = Join(this->approximationHistory_, approximation);
+    RowVector details = Join(this->detailHistory_, detail);
+
+    // Upsampling by two splits the filters into even and odd phases.
+    RowVector result(2 * count);
+
+    for (Index i = 0; i < count; ++i)
+    {
+        auto a = approximations.segment(i, phaseLength);
+        auto d = details.segment(i, phaseLength);
+
+        result(2 * i) = this->evenLow_.dot(a) + this->evenHigh_.dot(d);
+        result(2 * i + 1) = this->oddLow_.dot(a) + this->oddHigh_.dot(d);
+    }
+
+    auto historyLength = this->approximationHistory_.size();
+    this->approximationHistory_ = approximations.tail(historyLength);
+    this->detailHistory_ = details.tail(historyLength);
+
+    if (this->discardCount_ == 0)
+    {
+        return result;
+    }
+
+    Index discarded = std::min(this->discardCount_, result.size());
+    this->discardCount_ -= discarded;
+
+    return result.tail(result.size() - discarded);
+}
+
+
+} // end namespace detail
+
+
+StreamingCompressor::StreamingCompressor(const StreamingSettings &settings)
+    :
+    settings_(settings),
+    stages_(),
+    frame_(RowVector::Zero(settings.frameLength)),
+    frameCount_(0),
+    sampleCount_(0),
+    frameStart_(0),
+    latency_(0)
+{
+    if (settings.levelCount < 1)
+    {
+        throw std::invalid_argument("levelCount must be at least 1");
+    }
+
+    auto blockSize = Eigen::Index{1} << settings.levelCount;
+
+    if (settings.frameLength < 1 || settings.frameLength % blockSize != 0)
+    {
+        throw std::invalid_argument(
+            "frameLength must be a positive multiple of 2^levelCount");
+    }
+
+    auto wavelet = GetWavelet<double>(settings.wavelet);
+
+    for (size_t i = 0; i < settings.levelCount; ++i)
+    {
+        this->stages_.emplace_back(wavelet.decompose);
+    }
+
+    // Each synthesis stage delays its output by the filter length less two,
+    // at the sample rate of its level.
+    auto delay = wavelet.decompose.low.size() - 2;
+    this->latency_ = delay * (blockSize - 1) + blockSize;
+}
+
+
+std::vector<std::string> StreamingCompressor::Push(const RowVector &samples)
+{
+    std::vector<std::string> frames;
+    this->sampleCount_ += samples.size();
+    this->Append_(samples, frames);
+
+    return frames;
+}
+
+
+std::vector<std::string> StreamingCompressor::Finish()
+{
+    auto frameLength = this->settings_.frameLength;
+    auto needed = this->frameCount_ + this->latency_;
+
+    // Round up to whole frames.
+    auto paddingCount =
+        (needed + frameLength - 1) / frameLength * frameLength
+        - this->frameCount_;
+
+    std::vector<std::string> frames;
+    this->Append_(RowVector::Zero(paddingCount), frames);
+
+    return frames;
+}
+
+
+Eigen::Index StreamingCompressor::GetLatency() const
+{
+    return this->latency_;
+}
+
+
+void StreamingCompressor::Append_(
+    const RowVector &samples,
+    std::vector<std::string> &frames)
+{
+    auto frameLength = this->settings_.frameLength;
+    Eigen::Index consumed = 0;
+
+    while (consumed < samples.size())
+    {
+        auto count = std::min(
+            frameLength - this->frameCount_,
+            samples.size() - consumed);
+
+        this->frame_.segment(this->frameCount_, count) =
+            samples.segment(consumed, count);
+
+        this->frameCount_ += count;
+        consumed += count;
+
+        if (this->frameCount_ == frameLength)
+        {
+            frames.push_back(this->EncodeFrame_());
+            this->frameStart_ += frameLength;
+            this->frameCount_ = 0;
+        }
+    }
+}
+
+
+std::string StreamingCompressor::EncodeFrame_()
+{
+    auto levelCount = this->settings_.levelCount;
+
+    // Ordered as Decompose orders its rows, coarsest first.
+    Decomposed<double> decomposed(levelCount + 1);
+    RowVector approximation = this->frame_;
+
+    for (size_t i = 0; i < levelCount; ++i)
+    {
+        RowVector nextApproximation;
+        RowVector detail;
+
+        this->stages_[i].Process(approximation, nextApproximation, detail);
+        decomposed[levelCount - i] = detail;
+        approximation = nextApproximation;
+    }
+
+    decomposed[0] = approximation;
+
+    double threshold = PreserveHighest(decomposed, this->settings_.keepRatio);
+    double quantize = Quantize(decomposed, threshold);
+
+    auto sampleCount = std::clamp(
+        this->sampleCount_ - this->frameStart_,
+        Eigen::Index{0},
+        this->settings_.frameLength);
+
+    std::ostringstream output;
+    WriteVarint(output, static_cast<uint64_t>(sampleCount));
+    jive::io::Write(output, quantize);
+
+    Encode(
+        output,
+        decomposed,
+        this->settings_.enableMultibyteZeros,
+        this->settings_.enableGroupVarint);
+
+    return output.str();
+}
+
+
+StreamingDecompressor::StreamingDecompressor(
+    const StreamingSettings &settings)
+    :
+    settings_(settings),
+    stages_(),
+    approximations_(settings.levelCount),
+    details_(settings.levelCount),
+    sampleCount_(0),
+    returnedCount_(0)
+{
+    if (settings.levelCount < 1)
+    {
+        throw std::invalid_argument("levelCount must be at least 1");
+    }
+
+    auto wavelet = GetWavelet<double>(settings.wavelet);
+
+    for (size_t i = 0; i < settings.levelCount; ++i)
+    {
+        this->stages_.emplace_back(wavelet.recompose);
+    }
+}
+
+
+auto StreamingDecompressor::Push(const std::string &frame) -> RowVector
+{
+    std::istringstream input(frame);
+
+    auto frameSampleCount = ReadVarint(input);
+
+    // The count is read from the stream, and the total must fit an Index.
+    auto remaining = static_cast<uint64_t>(
+        std::numeric_limits<Eigen::Index>::max() - this->sampleCount_);
+
+    if (frameSampleCount > remaining)
+    {
+        throw std::runtime_error("Frame sample count out of range");
+    }
+
+    this->sampleCount_ += static_cast<Eigen::Index>(frameSampleCount);
+    auto quantize = jive::io::Read<double>(input);
+    auto decomposed = Decode(input, this->settings_.enableMultibyteZeros);
+
+    auto levelCount = this->settings_.levelCount;
+
+    if (decomposed.size() != levelCount + 1)
+    {
+        throw std::runtime_error("Frame does not match levelCount");
+    }
+
+    detail::AppendTo(this->approximations_[0], decomposed[0] * quantize);
+
+    for (size_t i = 0; i < levelCount; ++i)
+    {
+        detail::AppendTo(this->details_[i], decomposed[i + 1] * quantize);
+    }
+
+    RowVector result;
+
+    for (size_t i = 0; i < levelCount; ++i)
+    {
+        auto &approximations = this->approximations_[i];
+        auto &details = this->details_[i];
+        auto count = std::min(approximations.size(), details.size());
+
+        RowVector recomposed = this->stages_[i].Process(
+            approximations.head(count),
+            details.head(count));
+
+        approximations =
+            approximations.tail(approximations.size() - count).eval();
+
+        details = details.tail(details.size() - count).eval();
+
+        if (i + 1 < levelCount)
+        {
+            detail::AppendTo(this->approximations_[i + 1], recomposed);
+        }
+        else
+        {
+            result = recomposed;
+        }
+    }
+
+    // Samples beyond the end of the signal reconstruct the padding.
+    auto count = std::min(
+        result.size(),
+        this->sampleCount_ - this->returnedCount_);
+
+    this->returnedCount_ += count;
+
+    return result.head(count);
+}
+
+
+} // end namespace tau
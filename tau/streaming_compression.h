@@ -0,0 +1,198 @@
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <fields/fields.h>
+
+#include "tau/wavelet.h"
+#include "tau/wavelet_compression.h"
+
+
+namespace tau
+{
+
+
+struct StreamingSettings
+{
+    WaveletName wavelet;
+    double keepRatio;
+    bool enableMultibyteZeros;
+    bool enableGroupVarint;
+
+    // The count of samples in each encoded frame.
+    // Must be a multiple of 2^levelCount.
+    Eigen::Index frameLength;
+
+    // The count of detail rows in each frame.
+    size_t levelCount;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&StreamingSettings::wavelet, "wavelet"),
+        fields::Field(&StreamingSettings::keepRatio, "keepRatio"),
+        fields::Field(
+            &StreamingSettings::enableMultibyteZeros,
+            "enableMultibyteZeros"),
+        fields::Field(
+            &StreamingSettings::enableGroupVarint,
+            "enableGroupVarint"),
+        fields::Field(&StreamingSettings::frameLength, "frameLength"),
+        fields::Field(&StreamingSettings::levelCount, "levelCount"));
+
+    static StreamingSettings Default();
+};
+
+
+namespace detail
+{
+
+
+/**
+ ** One level of a causal analysis filter bank.
+ **
+ ** The last samples of each block are kept as history for the next, so the
+ ** output matches filtering the whole signal at once. Before the first
+ ** sample the signal is taken to be zero, as in Decompose without reflect.
+ **/
+class AnalysisStage
+{
+public:
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    explicit AnalysisStage(const WaveletFilter<double> &filter);
+
+    // input must have an even size. Appends input.size() / 2 coefficients
+    // to each of approximation and detail.
+    void Process(
+        const RowVector &input,
+        RowVector &approximation,
+        RowVector &detail);
+
+private:
+    RowVector low_;
+    RowVector high_;
+    RowVector history_;
+};
+
+
+/**
+ ** One level of the matching synthesis filter bank.
+ **
+ ** Filtering delays the output by the filter length less two, so those first
+ ** samples are discarded and the output lines up with the signal given to the
+ ** AnalysisStage.
+ **/
+class SynthesisStage
+{
+public:
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    explicit SynthesisStage(const WaveletFilter<double> &filter);
+
+    // Returns up to 2 * approximation.size() samples.
+    RowVector Process(
+        const RowVector &approximation,
+        const RowVector &detail);
+
+private:
+    // The even and odd phases of the filters, reversed.
+    RowVector evenLow_;
+    RowVector oddLow_;
+    RowVector evenHigh_;
+    RowVector oddHigh_;
+
+    RowVector approximationHistory_;
+    RowVector detailHistory_;
+    Eigen::Index discardCount_;
+};
+
+
+} // end namespace detail
+
+
+/**
+ ** Compresses a continuous signal in fixed-length frames.
+ **
+ ** The decomposition is carried from frame to frame by a filter bank with
+ ** state, so there are no padding artifacts at frame edges. Each frame holds
+ ** the coefficients computed from that frame's samples, as Decompose orders
+ ** them, quantized and encoded by Encode.
+ **
+ ** Frame layout:
+ **
+ **     sample count (varint) | quantize (double) | Encode payload
+ **
+ ** The sample count is frameLength for every frame except the zero-padded
+ ** frames written by Finish.
+ **/
+class StreamingCompressor
+{
+public:
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    explicit StreamingCompressor(const StreamingSettings &settings);
+
+    // Returns the frames completed by samples, if any.
+    std::vector<std::string> Push(const RowVector &samples);
+
+    /**
+     ** Pads with zeros until every pushed sample can be recovered, and
+     ** returns the remaining frames. Push must not be called afterward.
+     **/
+    std::vector<std::string> Finish();
+
+    // The count of samples the decoder lags behind the encoder.
+    Eigen::Index GetLatency() const;
+
+private:
+    void Append_(const RowVector &samples, std::vector<std::string> &frames);
+
+    std::string EncodeFrame_();
+
+    StreamingSettings settings_;
+    std::vector<detail::AnalysisStage> stages_;
+    RowVector frame_;
+    Eigen::Index frameCount_;
+
+    // Pushed samples, not counting the padding added by Finish.
+    Eigen::Index sampleCount_;
+
+    // The position of frame_ in the stream.
+    Eigen::Index frameStart_;
+
+    Eigen::Index latency_;
+};
+
+
+/**
+ ** Decodes the frames of a StreamingCompressor in order.
+ **
+ ** Each call to Push returns the samples that have become available. Over
+ ** the whole stream the samples returned match the samples given to the
+ ** compressor.
+ **/
+class StreamingDecompressor
+{
+public:
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    explicit StreamingDecompressor(const StreamingSettings &settings);
+
+    RowVector Push(const std::string &frame);
+
+private:
+    StreamingSettings settings_;
+    std::vector<detail::SynthesisStage> stages_;
+
+    // Coefficients waiting to be paired for each synthesis stage, coarsest
+    // first. The synthesis delay means approximations from the stage above
+    // trail the details decoded from frames.
+    std::vector<RowVector> approximations_;
+    std::vector<RowVector> details_;
+
+    Eigen::Index sampleCount_;
+    Eigen::Index returnedCount_;
+};
+
+
+} // end namespace tau
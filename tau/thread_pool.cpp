@@ -0,0 +1,102 @@
+#include "tau/thread_pool.h"
+
+#include <algorithm>
+
+
+namespace tau
+{
+
+
+ThreadPool::ThreadPool(size_t threadCount)
+    :
+    mutex_(),
+    condition_(),
+    jobs_(),
+    isRunning_(true),
+    threads_()
+{
+    if (threadCount == 0)
+    {
+        // hardware_concurrency is allowed to return 0 when the value is not
+        // computable.
+        threadCount =
+            std::max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                size_t{1});
+    }
+
+    this->threads_.reserve(threadCount);
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        this->threads_.emplace_back(&ThreadPool::Run_, this);
+    }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(this->mutex_);
+        this->isRunning_ = false;
+    }
+
+    this->condition_.notify_all();
+
+    for (auto &thread: this->threads_)
+    {
+        thread.join();
+    }
+}
+
+
+size_t ThreadPool::GetThreadCount() const
+{
+    return this->threads_.size();
+}
+
+
+void ThreadPool::Push_(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(this->mutex_);
+        this->jobs_.push_back(std::move(job));
+    }
+
+    this->condition_.notify_one();
+}
+
+
+void ThreadPool::Run_()
+{
+    while (true)
+    {
+        std::function<void()> job;
+
+        {
+            std::unique_lock lock(this->mutex_);
+
+            this->condition_.wait(
+                lock,
+                [this]()
+                {
+                    return !this->isRunning_ || !this->jobs_.empty();
+                });
+
+            if (this->jobs_.empty())
+            {
+                // The pool is stopping, and there is no work left.
+                return;
+            }
+
+            job = std::move(this->jobs_.front());
+            this->jobs_.pop_front();
+        }
+
+        // Exceptions are captured by the packaged_task and delivered through
+        // the future.
+        job();
+    }
+}
+
+
+} // end namespace tau
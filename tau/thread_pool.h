@@ -0,0 +1,71 @@
+#pragma once
+
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace tau
+{
+
+
+/**
+ ** A fixed set of worker threads servicing a shared queue of jobs.
+ **
+ ** Submit returns a std::future for the result of each job. Callers that need
+ ** results in submission order can keep the futures in a queue and consume
+ ** them from the front.
+ **/
+class ThreadPool
+{
+public:
+    // A threadCount of zero uses std::thread::hardware_concurrency.
+    explicit ThreadPool(size_t threadCount = 0);
+
+    // Waits for queued jobs to finish before joining the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    size_t GetThreadCount() const;
+
+    template<typename Function>
+    auto Submit(Function &&function)
+        -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+        // std::function requires a copyable target, and packaged_task is
+        // move-only.
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Function>(function));
+
+        auto result = task->get_future();
+        this->Push_([task]() { (*task)(); });
+
+        return result;
+    }
+
+private:
+    void Push_(std::function<void()> job);
+
+    void Run_();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> jobs_;
+    bool isRunning_;
+    std::vector<std::thread> threads_;
+};
+
+
+} // end namespace tau
@@ -0,0 +1,229 @@
+#pragma once
+
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "tau/mono_image.h"
+#include "tau/wavelet.h"
+
+
+namespace tau
+{
+
+
+/**
+ ** Separable 2D wavelet decomposition.
+ **
+ ** Each level filters the rows, then the columns, of the previous
+ ** approximation. The three detail bands of a level are ordered
+ ** {low rows/high columns, high rows/low columns, high rows/high columns},
+ ** where "rows" is the filter applied along each row.
+ **/
+template<typename T>
+struct Decomposed2d
+{
+    MonoImage<T> approximation;
+
+    // Coarsest level first, as in Decomposed.
+    std::vector<std::array<MonoImage<T>, 3>> details;
+
+    // The size of the decomposed image, needed to trim the recomposition.
+    Eigen::Index rowCount;
+    Eigen::Index columnCount;
+};
+
+
+namespace detail
+{
+
+
+// Decomposes each row one level. Returns the approximation and detail.
+template<typename T>
+std::pair<MonoImage<T>, MonoImage<T>> SplitRows(
+    const Wavelet<T> &wavelet,
+    const MonoImage<T> &image,
+    bool reflect)
+{
+    using RowVector = Eigen::RowVector<T, Eigen::Dynamic>;
+
+    MonoImage<T> approximation;
+    MonoImage<T> detail;
+
+    for (Eigen::Index row = 0; row < image.rows(); ++row)
+    {
+        auto decomposed =
+            Decompose(wavelet, RowVector(image.row(row)), reflect, 1);
+
+        assert(decomposed.size() == 2);
+
+        if (row == 0)
+        {
+            approximation.resize(image.rows(), decomposed[0].size());
+            detail.resize(image.rows(), decomposed[1].size());
+        }
+
+        approximation.row(row) = decomposed[0];
+        detail.row(row) = decomposed[1];
+    }
+
+    return {approximation, detail};
+}
+
+
+// Inverts SplitRows, trimming each row to columnCount.
+template<typename T>
+MonoImage<T> MergeRows(
+    const Wavelet<T> &wavelet,
+    const MonoImage<T> &approximation,
+    const MonoImage<T> &detail,
+    bool reflect,
+    Eigen::Index columnCount)
+{
+    using RowVector = Eigen::RowVector<T, Eigen::Dynamic>;
+
+    MonoImage<T> result(approximation.rows(), columnCount);
+
+    for (Eigen::Index row = 0; row < approximation.rows(); ++row)
+    {
+        Decomposed<T> decomposed{
+            RowVector(approximation.row(row)),
+            RowVector(detail.row(row))};
+
+        result.row(row) =
+            Recompose(wavelet, decomposed, reflect).head(columnCount);
+    }
+
+    return result;
+}
+
+
+template<typename T>
+std::pair<MonoImage<T>, MonoImage<T>> SplitColumns(
+    const Wavelet<T> &wavelet,
+    const MonoImage<T> &image,
+    bool reflect)
+{
+    auto [approximation, detail] =
+        SplitRows<T>(wavelet, image.transpose(), reflect);
+
+    return {approximation.transpose(), detail.transpose()};
+}
+
+
+template<typename T>
+MonoImage<T> MergeColumns(
+    const Wavelet<T> &wavelet,
+    const MonoImage<T> &approximation,
+    const MonoImage<T> &detail,
+    bool reflect,
+    Eigen::Index rowCount)
+{
+    return MergeRows<T>(
+        wavelet,
+        approximation.transpose(),
+        detail.transpose(),
+        reflect,
+        rowCount).transpose();
+}
+
+
+} // end namespace detail
+
+
+// The deepest level that keeps both dimensions longer than the filter.
+template<typename T>
+size_t GetMaximumLevel2d(
+    const Wavelet<T> &wavelet,
+    Eigen::Index rowCount,
+    Eigen::Index columnCount)
+{
+    return wavelet.GetMaximumLevel(std::min(rowCount, columnCount));
+}
+
+
+template<typename T>
+Decomposed2d<T> Decompose2d(
+    const Wavelet<T> &wavelet,
+    const MonoImage<T> &image,
+    bool reflect = false,
+    std::optional<size_t> level = {})
+{
+    size_t levelCount =
+        GetMaximumLevel2d(wavelet, image.rows(), image.cols());
+
+    if (level)
+    {
+        levelCount = std::min(*level, levelCount);
+    }
+
+    Decomposed2d<T> result{image, {}, image.rows(), image.cols()};
+
+    while (levelCount--)
+    {
+        auto [low, high] =
+            detail::SplitRows(wavelet, result.approximation, reflect);
+
+        auto [lowLow, lowHigh] = detail::SplitColumns(wavelet, low, reflect);
+        auto [highLow, highHigh] = detail::SplitColumns(wavelet, high, reflect);
+
+        result.approximation = lowLow;
+        result.details.push_back({lowHigh, highLow, highHigh});
+    }
+
+    std::reverse(std::begin(result.details), std::end(result.details));
+
+    return result;
+}
+
+
+template<typename T>
+MonoImage<T> Recompose2d(
+    const Wavelet<T> &wavelet,
+    const Decomposed2d<T> &decomposed,
+    bool reflect = false)
+{
+    // The size of the approximation that was split at each level, finest
+    // first.
+    std::vector<std::pair<Eigen::Index, Eigen::Index>> sizes;
+    Eigen::Index rowCount = decomposed.rowCount;
+    Eigen::Index columnCount = decomposed.columnCount;
+
+    for (size_t i = 0; i < decomposed.details.size(); ++i)
+    {
+        sizes.emplace_back(rowCount, columnCount);
+        auto &bands = decomposed.details[decomposed.details.size() - 1 - i];
+        rowCount = bands[0].rows();
+        columnCount = bands[0].cols();
+    }
+
+    MonoImage<T> result = decomposed.approximation;
+
+    for (size_t i = 0; i < decomposed.details.size(); ++i)
+    {
+        auto &bands = decomposed.details[i];
+        auto [levelRows, levelColumns] = sizes[sizes.size() - 1 - i];
+
+        MonoImage<T> low = detail::MergeColumns(
+            wavelet,
+            result,
+            bands[0],
+            reflect,
+            levelRows);
+
+        MonoImage<T> high = detail::MergeColumns(
+            wavelet,
+            bands[1],
+            bands[2],
+            reflect,
+            levelRows);
+
+        result = detail::MergeRows(wavelet, low, high, reflect, levelColumns);
+    }
+
+    return result;
+}
+
+
+} // end namespace tau
@@ -1,5 +1,7 @@
 #include "tau/wavelet_compression.h"
 #include <fmt/core.h>
+#include <bit>
+#include <cstring>
 
 
 namespace tau
@@ -115,158 +117,375 @@ int64_t ReadValue(uint8_t firstByte, std::istream &input)
 }
 
 
+size_t GetValueSize(int64_t value)
+{
+    if (value >= -32 && value <= 31)
+    {
+        return 1;
+    }
+    else if (Convertible<int8_t>(value))
+    {
+        return 2;
+    }
+    else if (Convertible<int16_t>(value))
+    {
+        return 3;
+    }
+    else if (Convertible<int32_t>(value))
+    {
+        return 5;
+    }
+
+    return 9;
+}
+
+
 // 2 ** 14 - 1
 static constexpr int multibyteMaximumZeroCount = 16383;
 
 
-void EncodeRow(
-    std::ostream &output,
-    const Eigen::RowVector<double, Eigen::Dynamic> &row,
+size_t GetZeroRunSize(size_t zeroCount, bool enableMultibyteZeros)
+{
+    if (!enableMultibyteZeros)
+    {
+        // Full blocks of 127 zeros take one byte, and so does any remainder.
+        return zeroCount / 127 + ((zeroCount % 127) ? 1 : 0);
+    }
+
+    static constexpr auto maximumZeroCount =
+        static_cast<size_t>(multibyteMaximumZeroCount);
+
+    size_t remainder = zeroCount % maximumZeroCount;
+    size_t result = 2 * (zeroCount / maximumZeroCount);
+
+    if (remainder == 0)
+    {
+        return result;
+    }
+
+    return result + ((remainder <= 127) ? 1 : 2);
+}
+
+
+namespace detail
+{
+
+
+// Appends in host byte order, like jive::io::Write.
+template<typename T>
+void Append(std::string &buffer, T value)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buffer.append(bytes, sizeof(T));
+}
+
+
+void AppendZeroRun(
+    std::string &buffer,
+    size_t zeroCount,
     bool enableMultibyteZeros)
 {
-    int zeroCount = -1;
-    int maximumZeroCount;
-    int singleByteMaximumZeroCount;
+    if (!enableMultibyteZeros)
+    {
+        for (; zeroCount >= 127; zeroCount -= 127)
+        {
+            // A full block of zeros
+            buffer.push_back(static_cast<char>(0xFF));
+        }
 
-    if (enableMultibyteZeros)
+        if (zeroCount)
+        {
+            buffer.push_back(static_cast<char>(128 + zeroCount));
+        }
+
+        return;
+    }
+
+    static constexpr auto maximumZeroCount =
+        static_cast<size_t>(multibyteMaximumZeroCount);
+
+    for (; zeroCount >= maximumZeroCount; zeroCount -= maximumZeroCount)
+    {
+        // A full block of zeros
+        Append(buffer, static_cast<uint16_t>(0xFFFF));
+    }
+
+    if (zeroCount == 0)
     {
-        maximumZeroCount = multibyteMaximumZeroCount;
-        singleByteMaximumZeroCount = 127;
+        return;
+    }
+
+    if (zeroCount <= 127)
+    {
+        buffer.push_back(static_cast<char>(128 + zeroCount));
     }
     else
     {
-        singleByteMaximumZeroCount = 127;
-        maximumZeroCount = singleByteMaximumZeroCount;
+        buffer.push_back(static_cast<char>(0x80 | (zeroCount / 128)));
+        buffer.push_back(static_cast<char>(0x80 | (zeroCount % 128)));
     }
+}
+
+
+/**
+ ** Each value is classified by the count of ranges it falls outside of:
+ ** 6-bit, int8_t, int16_t, and int32_t.
+ ** 0 fits in the control byte, and 1 through 4 select the width written after
+ ** it.
+ **/
+using WidthClasses = Eigen::Array<uint8_t, 1, Eigen::Dynamic>;
+using Integers = Eigen::Array<int64_t, 1, Eigen::Dynamic>;
+
+
+template<typename T>
+auto IsOutside(const Integers &integers)
+{
+    using Limits = std::numeric_limits<T>;
 
-    for (auto value: row)
+    return (integers < Limits::min() || integers > Limits::max())
+        .template cast<uint8_t>();
+}
+
+
+WidthClasses ClassifyWidths(const Integers &integers)
+{
+    return (integers < -32 || integers > 31).template cast<uint8_t>()
+        + IsOutside<int8_t>(integers)
+        + IsOutside<int16_t>(integers)
+        + IsOutside<int32_t>(integers);
+}
+
+
+void AppendValue(std::string &buffer, int64_t value, uint8_t widthClass)
+{
+    switch (widthClass)
     {
-        if (static_cast<int>(value) == 0)
-        {
-            if (zeroCount == -1)
-            {
-                // This is the first in a string of zeros
-                zeroCount = 1;
-                continue;
-            }
+        case 0:
+            buffer.push_back(
+                static_cast<char>(
+                    MoveSignBit(static_cast<int8_t>(value), 6)));
+            break;
+
+        case 1:
+            buffer.push_back(static_cast<char>(0x41));
+            Append(buffer, static_cast<int8_t>(value));
+            break;
+
+        case 2:
+            buffer.push_back(static_cast<char>(0x42));
+            Append(buffer, static_cast<int16_t>(value));
+            break;
+
+        case 3:
+            buffer.push_back(static_cast<char>(0x44));
+            Append(buffer, static_cast<int32_t>(value));
+            break;
+
+        default:
+            buffer.push_back(static_cast<char>(0x48));
+            Append(buffer, value);
+            break;
+    }
+}
 
-            zeroCount += 1;
 
-            if (zeroCount == maximumZeroCount)
-            {
-                if (enableMultibyteZeros)
-                {
-                    // We have a full block of zeros
-                    jive::io::Write(output, static_cast<uint16_t>(0xFFFF));
-                }
-                else
-                {
-                    jive::io::Write(output, static_cast<uint8_t>(0xFF));
-                }
+/**
+ ** Returns the index of the first nonzero value at or after begin, or end.
+ **
+ ** Whole blocks are tested with a branch-free OR reduction, which the
+ ** compiler turns into packed compares, so long runs of zeros are skipped a
+ ** block at a time.
+ **/
+Eigen::Index FindNonzero(
+    const int64_t *values,
+    Eigen::Index begin,
+    Eigen::Index end)
+{
+    static constexpr Eigen::Index blockSize = 16;
 
-                // Restart a new block of zeros
-                zeroCount = -1;
-            }
+    while (end - begin >= blockSize)
+    {
+        int64_t combined = 0;
 
-            continue;
+        for (Eigen::Index i = 0; i < blockSize; ++i)
+        {
+            combined |= values[begin + i];
         }
-        else
+
+        if (combined != 0)
         {
-            if (zeroCount != -1)
-            {
-                if (enableMultibyteZeros)
-                {
-                    // We were in the middle of a block of zeros.
-                    // Write out the count.
-                    if (zeroCount <= singleByteMaximumZeroCount)
-                    {
-                        jive::io::Write(
-                            output,
-                            static_cast<uint8_t>(128 + zeroCount));
-                    }
-                    else
-                    {
-                        uint8_t highByte =
-                            static_cast<uint8_t>(0x80 | (zeroCount / 128));
-
-                        uint8_t lowByte =
-                            static_cast<uint8_t>(0x80 | (zeroCount % 128));
-
-                        jive::io::Write(output, highByte);
-                        jive::io::Write(output, lowByte);
-                    }
-                }
-                else
-                {
-                    jive::io::Write(
-                        output,
-                        static_cast<uint8_t>(128 + zeroCount));
-                }
+            break;
+        }
 
-                zeroCount = -1;
-            }
+        begin += blockSize;
+    }
 
-            // Write out the value
-            WriteValue(output, static_cast<int64_t>(value));
-        }
+    while (begin < end && values[begin] == 0)
+    {
+        ++begin;
     }
 
-    if (zeroCount != -1)
+    return begin;
+}
+
+
+} // end namespace detail
+
+
+template<typename T>
+void EncodeRow(
+    std::ostream &output,
+    const Eigen::RowVector<T, Eigen::Dynamic> &row,
+    bool enableMultibyteZeros)
+{
+    using Eigen::Index;
+
+    // Conversion and classification are done in bulk, ahead of the scan.
+    // Truncation toward zero matches the integral values written by
+    // WriteValue.
+    detail::Integers integers = row.array().template cast<int64_t>();
+    detail::WidthClasses widthClasses = detail::ClassifyWidths(integers);
+
+    std::string buffer;
+    buffer.reserve(static_cast<size_t>(row.size()));
+
+    Index size = integers.size();
+    Index index = 0;
+
+    while (index < size)
     {
-        // We have a leftover block of zeros to write
-        if (enableMultibyteZeros)
+        Index next = detail::FindNonzero(integers.data(), index, size);
+
+        if (next > index)
         {
-            // We were in the middle of a block of zeros.
-            // Write out the count.
-            if (zeroCount <= singleByteMaximumZeroCount)
-            {
-                jive::io::Write(
-                    output,
-                    static_cast<uint8_t>(128 + zeroCount));
-            }
-            else
-            {
-                uint8_t highByte =
-                    static_cast<uint8_t>(0x80 | (zeroCount / 128));
+            detail::AppendZeroRun(
+                buffer,
+                static_cast<size_t>(next - index),
+                enableMultibyteZeros);
+        }
 
-                uint8_t lowByte =
-                    static_cast<uint8_t>(0x80 | (zeroCount % 128));
+        if (next == size)
+        {
+            break;
+        }
 
-                jive::io::Write(output, highByte);
-                jive::io::Write(output, lowByte);
-            }
+        detail::AppendValue(buffer, integers(next), widthClasses(next));
+        index = next + 1;
+    }
+
+    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+
+void WriteVarint(std::ostream &output, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        jive::io::Write(output, static_cast<uint8_t>(0x80 | (value & 0x7F)));
+        value >>= 7;
+    }
+
+    jive::io::Write(output, static_cast<uint8_t>(value));
+}
+
+
+uint64_t ReadVarint(std::istream &input)
+{
+    uint64_t result = 0;
+    unsigned shift = 0;
+
+    while (true)
+    {
+        auto next = jive::io::Read<uint8_t>(input);
+
+        if (!input.good())
+        {
+            throw std::runtime_error("input is not good");
         }
-        else
+
+        // Only the lowest bit of a tenth byte fits in 64 bits.
+        if (shift > 63 || (shift == 63 && (next & 0x7E)))
         {
-            jive::io::Write(
-                output,
-                static_cast<uint8_t>(128 + zeroCount));
+            throw std::runtime_error("varint exceeds 64 bits");
         }
+
+        result |= static_cast<uint64_t>(next & 0x7F) << shift;
+
+        if (!(next & 0x80))
+        {
+            return result;
+        }
+
+        shift += 7;
     }
 }
 
 
+size_t GetVarintSize(uint64_t value)
+{
+    size_t result = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++result;
+    }
+
+    return result;
+}
+
+
+template<typename T>
 void Encode(
     std::ostream &output,
-    const Decomposed<double> &decomposed,
-    bool enableMultibyteZeros)
+    const Decomposed<T> &decomposed,
+    bool enableMultibyteZeros,
+    bool enableGroupVarint)
 {
-    size_t rowCount = decomposed.size();
-    jive::io::Write(output, static_cast<uint8_t>(rowCount));
+    for (auto byte: format::magic)
+    {
+        jive::io::Write(output, byte);
+    }
+
+    jive::io::Write(output, format::version);
+
+    uint8_t flags = 0;
+
+    if (enableMultibyteZeros)
+    {
+        flags |= format::multibyteZeros;
+    }
+
+    if (enableGroupVarint)
+    {
+        flags |= format::groupVarint;
+    }
+
+    jive::io::Write(output, flags);
+
+    WriteVarint(output, decomposed.size());
 
     for (auto &row: decomposed)
     {
-        jive::io::Write(output, static_cast<uint16_t>(row.size()));
+        WriteVarint(output, static_cast<uint64_t>(row.size()));
     }
 
     for (auto &row: decomposed)
     {
-        EncodeRow(output, row, enableMultibyteZeros);
+        if (enableGroupVarint)
+        {
+            EncodeGroupRow(output, row);
+        }
+        else
+        {
+            EncodeRow(output, row, enableMultibyteZeros);
+        }
     }
 }
 
 
-uint16_t ReadZeros(
+size_t ReadZeros(
     uint8_t firstByte,
     std::istream &input,
     bool enableMultibyteZeros,
@@ -291,7 +510,8 @@ uint16_t ReadZeros(
     if (secondByte & 0x80)
     {
         // This is a two byte zero block.
-        return (firstByteMasked * 128) + (secondByte & 0x7F);
+        return static_cast<size_t>(firstByteMasked) * 128
+            + (secondByte & 0x7Fu);
     }
     else
     {
@@ -304,15 +524,57 @@ uint16_t ReadZeros(
 }
 
 
-Eigen::RowVector<double, Eigen::Dynamic> DecodeRow(
+namespace detail
+{
+
+
+template<typename T>
+T ToCoefficient(int64_t value)
+{
+    if constexpr (std::is_integral_v<T> && sizeof(T) < sizeof(int64_t))
+    {
+        using Limits = std::numeric_limits<T>;
+
+        if (value < Limits::min() || value > Limits::max())
+        {
+            throw std::runtime_error(
+                fmt::format("Decoded value out of range: {}", value));
+        }
+    }
+
+    return static_cast<T>(value);
+}
+
+
+// Row lengths come from the stream, and must fit the size of a RowVector.
+void RequireRowLength(uint64_t length)
+{
+    static constexpr auto maximum =
+        static_cast<uint64_t>(std::numeric_limits<Eigen::Index>::max());
+
+    if (length > maximum)
+    {
+        throw std::runtime_error(
+            fmt::format("Row length out of range: {}", length));
+    }
+}
+
+
+} // end namespace detail
+
+
+template<typename T>
+Eigen::RowVector<T, Eigen::Dynamic> DecodeRow(
     std::istream &input,
-    uint16_t length,
+    size_t length,
     bool enableMultibyteZeros)
 {
     using Eigen::Index;
 
-    uint16_t decodedCount = 0;
-    Eigen::RowVector<double, Eigen::Dynamic> row(static_cast<Index>(length));
+    detail::RequireRowLength(length);
+
+    size_t decodedCount = 0;
+    Eigen::RowVector<T, Eigen::Dynamic> row(static_cast<Index>(length));
 
     while (decodedCount < length)
     {
@@ -321,7 +583,7 @@ Eigen::RowVector<double, Eigen::Dynamic> DecodeRow(
         if (entry & 0x80)
         {
             // Block bit is set
-            uint16_t zeroCount = ReadZeros(
+            size_t zeroCount = ReadZeros(
                 entry,
                 input,
                 enableMultibyteZeros,
@@ -339,12 +601,17 @@ Eigen::RowVector<double, Eigen::Dynamic> DecodeRow(
                 throw std::runtime_error("bad zerocount");
             }
 
-            row(Eigen::seqN(decodedCount, zeroCount)).array() = 0;
+            row(
+                Eigen::seqN(
+                    static_cast<Index>(decodedCount),
+                    static_cast<Index>(zeroCount))).array() = 0;
+
             decodedCount += zeroCount;
         }
         else
         {
-            row(decodedCount) = static_cast<double>(ReadValue(entry, input));
+            row(static_cast<Index>(decodedCount)) =
+                detail::ToCoefficient<T>(ReadValue(entry, input));
             decodedCount += 1;
         }
     }
@@ -353,56 +620,370 @@ Eigen::RowVector<double, Eigen::Dynamic> DecodeRow(
 }
 
 
-Decomposed<double> Decode(
+namespace detail
+{
+
+
+uint64_t ToZigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1)
+        ^ static_cast<uint64_t>(value >> 63);
+}
+
+
+int64_t FromZigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1)
+        ^ -static_cast<int64_t>(value & 1);
+}
+
+
+constexpr uint64_t GetByteMask(size_t byteCount)
+{
+    if (byteCount >= 8)
+    {
+        return ~uint64_t{0};
+    }
+
+    return (uint64_t{1} << (8 * byteCount)) - 1;
+}
+
+
+/**
+ ** The decode table entry for one control byte: where each of the four
+ ** values starts in the value bytes, the mask that keeps only its bytes, and
+ ** the count of value bytes used by the group.
+ **/
+struct GroupLayout
+{
+    std::array<uint8_t, 4> offsets;
+    std::array<uint64_t, 4> masks;
+    uint8_t byteCount;
+};
+
+
+using GroupLayouts = std::array<GroupLayout, 256>;
+
+
+constexpr GroupLayouts MakeGroupLayouts(uint8_t wideSize)
+{
+    GroupLayouts result{};
+    const std::array<uint8_t, 4> sizes{0, 1, 2, wideSize};
+
+    for (size_t control = 0; control < 256; ++control)
+    {
+        auto &layout = result[control];
+        uint8_t offset = 0;
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            auto size = sizes[(control >> (2 * i)) & 0x03];
+            layout.offsets[i] = offset;
+
+            layout.masks[i] = GetByteMask(size);
+
+            offset = static_cast<uint8_t>(offset + size);
+        }
+
+        layout.byteCount = offset;
+    }
+
+    return result;
+}
+
+
+constexpr GroupLayouts narrowGroupLayouts = MakeGroupLayouts(4);
+constexpr GroupLayouts wideGroupLayouts = MakeGroupLayouts(8);
+
+
+// Reads 8 bytes as a little-endian value.
+uint64_t LoadLittleEndian(const uint8_t *bytes)
+{
+    uint64_t result;
+
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        std::memcpy(&result, bytes, sizeof(result));
+    }
+    else
+    {
+        result = 0;
+
+        for (size_t i = 0; i < sizeof(result); ++i)
+        {
+            result |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        }
+    }
+
+    return result;
+}
+
+
+uint8_t GetGroupCode(uint64_t zigzag)
+{
+    if (zigzag == 0)
+    {
+        return 0;
+    }
+
+    if (zigzag <= 0xFF)
+    {
+        return 1;
+    }
+
+    if (zigzag <= 0xFFFF)
+    {
+        return 2;
+    }
+
+    return 3;
+}
+
+
+} // end namespace detail
+
+
+template<typename T>
+void EncodeGroupRow(
+    std::ostream &output,
+    const Eigen::RowVector<T, Eigen::Dynamic> &row)
+{
+    auto valueCount = static_cast<size_t>(row.size());
+    std::vector<uint64_t> zigzags(valueCount);
+    uint64_t combined = 0;
+
+    for (size_t i = 0; i < valueCount; ++i)
+    {
+        zigzags[i] = detail::ToZigzag(
+            static_cast<int64_t>(row(static_cast<Eigen::Index>(i))));
+
+        combined |= zigzags[i];
+    }
+
+    uint8_t wideSize = (combined > 0xFFFFFFFF) ? 8 : 4;
+    const std::array<size_t, 4> sizes{0, 1, 2, wideSize};
+
+    std::string controls((valueCount + 3) / 4, '\0');
+    std::string values;
+    values.reserve(valueCount);
+
+    for (size_t i = 0; i < valueCount; ++i)
+    {
+        auto code = detail::GetGroupCode(zigzags[i]);
+
+        controls[i / 4] = static_cast<char>(
+            static_cast<uint8_t>(controls[i / 4]) | (code << (2 * (i % 4))));
+
+        for (size_t j = 0; j < sizes[code]; ++j)
+        {
+            values.push_back(static_cast<char>(zigzags[i] >> (8 * j)));
+        }
+    }
+
+    jive::io::Write(output, wideSize);
+
+    output.write(
+        controls.data(),
+        static_cast<std::streamsize>(controls.size()));
+
+    output.write(values.data(), static_cast<std::streamsize>(values.size()));
+}
+
+
+template<typename T>
+Eigen::RowVector<T, Eigen::Dynamic> DecodeGroupRow(
+    std::istream &input,
+    size_t length)
+{
+    using Eigen::Index;
+
+    detail::RequireRowLength(length);
+
+    auto wideSize = jive::io::Read<uint8_t>(input);
+
+    if (wideSize != 4 && wideSize != 8)
+    {
+        throw std::runtime_error(
+            fmt::format("Bad group varint wide size: {}", wideSize));
+    }
+
+    const auto &layouts = (wideSize == 8)
+        ? detail::wideGroupLayouts
+        : detail::narrowGroupLayouts;
+
+    std::vector<uint8_t> controls((length + 3) / 4);
+
+    input.read(
+        reinterpret_cast<char *>(controls.data()),
+        static_cast<std::streamsize>(controls.size()));
+
+    size_t valueByteCount = 0;
+
+    for (auto control: controls)
+    {
+        valueByteCount += layouts[control].byteCount;
+    }
+
+    // Padding lets every value be loaded with one 8-byte read.
+    std::vector<uint8_t> values(valueByteCount + 8, 0);
+
+    input.read(
+        reinterpret_cast<char *>(values.data()),
+        static_cast<std::streamsize>(valueByteCount));
+
+    if (!input)
+    {
+        throw std::runtime_error("Truncated group varint row");
+    }
+
+    Eigen::RowVector<T, Eigen::Dynamic> row(static_cast<Index>(length));
+    const uint8_t *valueBytes = values.data();
+    size_t fullGroupCount = length / 4;
+
+    for (size_t group = 0; group < fullGroupCount; ++group)
+    {
+        const auto &layout = layouts[controls[group]];
+        auto first = static_cast<Index>(4 * group);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            auto zigzag = detail::LoadLittleEndian(
+                valueBytes + layout.offsets[i]) & layout.masks[i];
+
+            row(first + static_cast<Index>(i)) =
+                detail::ToCoefficient<T>(detail::FromZigzag(zigzag));
+        }
+
+        valueBytes += layout.byteCount;
+    }
+
+    if (fullGroupCount < controls.size())
+    {
+        // The unused codes of the last group are zero and take no bytes.
+        const auto &layout = layouts[controls.back()];
+
+        for (size_t i = 0; i < length % 4; ++i)
+        {
+            auto zigzag = detail::LoadLittleEndian(
+                valueBytes + layout.offsets[i]) & layout.masks[i];
+
+            row(static_cast<Index>(4 * fullGroupCount + i)) =
+                detail::ToCoefficient<T>(detail::FromZigzag(zigzag));
+        }
+    }
+
+    return row;
+}
+
+
+template<typename T>
+Decomposed<T> Decode(
     std::istream &input,
     bool enableMultibyteZeros)
 {
-    Decomposed<double> result;
-    auto rowCount = jive::io::Read<uint8_t>(input);
-    std::vector<uint16_t> rowLengths;
+    Decomposed<T> result;
+    std::vector<size_t> rowLengths;
+    bool enableGroupVarint = false;
+
+    auto firstByte = jive::io::Read<uint8_t>(input);
 
-    for (uint8_t i = 0; i < rowCount; ++i)
+    if (firstByte != format::magic[0])
     {
-        rowLengths.push_back(jive::io::Read<uint16_t>(input));
+        // Unversioned layout.
+        // The first byte is the row count.
+        for (uint8_t i = 0; i < firstByte; ++i)
+        {
+            rowLengths.push_back(jive::io::Read<uint16_t>(input));
+        }
+    }
+    else
+    {
+        for (size_t i = 1; i < format::magic.size(); ++i)
+        {
+            if (jive::io::Read<uint8_t>(input) != format::magic[i])
+            {
+                throw std::runtime_error("Bad magic");
+            }
+        }
+
+        auto version = jive::io::Read<uint8_t>(input);
+
+        if (version < format::minimumVersion || version > format::version)
+        {
+            throw std::runtime_error(
+                fmt::format("Unsupported version: {}", version));
+        }
+
+        auto flags = jive::io::Read<uint8_t>(input);
+        enableMultibyteZeros = (flags & format::multibyteZeros);
+        enableGroupVarint = (flags & format::groupVarint);
+
+        auto rowCount = ReadVarint(input);
+
+        for (uint64_t i = 0; i < rowCount; ++i)
+        {
+            auto length = ReadVarint(input);
+            detail::RequireRowLength(length);
+            rowLengths.push_back(length);
+        }
     }
 
     for (auto length: rowLengths)
     {
-        result.push_back(DecodeRow(input, length, enableMultibyteZeros));
+        if (enableGroupVarint)
+        {
+            result.push_back(DecodeGroupRow<T>(input, length));
+        }
+        else
+        {
+            result.push_back(
+                DecodeRow<T>(input, length, enableMultibyteZeros));
+        }
     }
 
     return result;
 }
 
 
-double PreserveHighest(Decomposed<double> &decomposed, double keepRatio)
+template<typename T>
+void ZeroBelow(Decomposed<T> &decomposed, double threshold)
 {
-    Eigen::Index valueCount = 0;
+    auto typedThreshold = static_cast<T>(threshold);
 
     for (auto &row: decomposed)
     {
-        valueCount += row.size();
+        row = (row.array().abs() < typedThreshold).select(T(0), row);
     }
+}
 
-    auto sortedCount =
-        static_cast<size_t>(keepRatio * static_cast<double>(valueCount));
 
-    auto highest = SortHighest(sortedCount, decomposed);
-    double threshold = std::max(1.0, *highest.begin());
+template<typename T>
+double PreserveHighest(Decomposed<T> &decomposed, double keepRatio)
+{
+    Eigen::Index valueCount = 0;
 
     for (auto &row: decomposed)
     {
-        row = (row.array().abs() < threshold).select(0, row);
+        valueCount += row.size();
     }
 
+    // Keep at least one coefficient so that the threshold is defined.
+    auto sortedCount = std::max(
+        size_t{1},
+        static_cast<size_t>(keepRatio * static_cast<double>(valueCount)));
+
+    auto highest = SortHighest(sortedCount, decomposed);
+
+    double threshold =
+        std::max(1.0, static_cast<double>(*highest.begin()));
+
+    ZeroBelow(decomposed, threshold);
+
     return threshold;
 }
 
 
-double Quantize(
-    Decomposed<double> &decomposed,
-    double threshold,
-    std::optional<QuantizeRange> range)
+double GetQuantize(double threshold, std::optional<QuantizeRange> range)
 {
     double quantize = std::round(threshold);
 
@@ -414,15 +995,137 @@ double Quantize(
 
     // Minimum quantize is 1.
     // Smaller values would increase the size of coefficients.
-    quantize = std::max(quantize, 1.0);
+    return std::max(quantize, 1.0);
+}
+
+
+template<typename T>
+double Quantize(
+    Decomposed<T> &decomposed,
+    double threshold,
+    std::optional<QuantizeRange> range)
+{
+    double quantize = GetQuantize(threshold, range);
+    auto typedQuantize = static_cast<T>(quantize);
 
     for (auto &row: decomposed)
     {
-        row.array() = (row.array() / quantize).round();
+        row.array() = (row.array() / typedQuantize).round();
+    }
+
+    return quantize;
+}
+
+
+template<typename Integer, typename T>
+double Quantize(
+    const Decomposed<T> &decomposed,
+    Decomposed<Integer> &quantized,
+    double threshold,
+    std::optional<QuantizeRange> range)
+{
+    static_assert(std::is_signed_v<Integer>);
+    using Limits = std::numeric_limits<Integer>;
+
+    // The limits are powers of two, so both are exact in double. highest is
+    // one past Limits::max().
+    const auto lowest = static_cast<double>(Limits::min());
+    const double highest = -lowest;
+
+    double quantize = GetQuantize(threshold, range);
+    auto typedQuantize = static_cast<T>(quantize);
+
+    quantized.clear();
+    quantized.reserve(decomposed.size());
+
+    for (auto &row: decomposed)
+    {
+        Eigen::Array<T, 1, Eigen::Dynamic> rounded =
+            (row.array() / typedQuantize).round();
+
+        // As a float, Limits::max() of int32_t would round up to 2^31, which
+        // does not fit. NaN fails every comparison, so it is checked first.
+        if (rounded.size()
+            && (!rounded.isFinite().all()
+                || static_cast<double>(rounded.minCoeff()) < lowest
+                || static_cast<double>(rounded.maxCoeff()) >= highest))
+        {
+            throw std::runtime_error(
+                "Quantized coefficient out of range");
+        }
+
+        quantized.push_back(rounded.template cast<Integer>().matrix());
     }
 
     return quantize;
 }
 
 
+template<typename T>
+using Row = Eigen::RowVector<T, Eigen::Dynamic>;
+
+
+template void EncodeRow<float>(std::ostream &, const Row<float> &, bool);
+template void EncodeRow<double>(std::ostream &, const Row<double> &, bool);
+template void EncodeRow<int32_t>(std::ostream &, const Row<int32_t> &, bool);
+
+
+template void EncodeGroupRow<float>(std::ostream &, const Row<float> &);
+template void EncodeGroupRow<double>(std::ostream &, const Row<double> &);
+template void EncodeGroupRow<int32_t>(std::ostream &, const Row<int32_t> &);
+
+
+template Row<float> DecodeRow<float>(std::istream &, size_t, bool);
+template Row<double> DecodeRow<double>(std::istream &, size_t, bool);
+template Row<int32_t> DecodeRow<int32_t>(std::istream &, size_t, bool);
+
+
+template Row<float> DecodeGroupRow<float>(std::istream &, size_t);
+template Row<double> DecodeGroupRow<double>(std::istream &, size_t);
+template Row<int32_t> DecodeGroupRow<int32_t>(std::istream &, size_t);
+
+
+template void Encode<float>(
+    std::ostream &, const Decomposed<float> &, bool, bool);
+
+template void Encode<double>(
+    std::ostream &, const Decomposed<double> &, bool, bool);
+
+template void Encode<int32_t>(
+    std::ostream &, const Decomposed<int32_t> &, bool, bool);
+
+
+template Decomposed<float> Decode<float>(std::istream &, bool);
+template Decomposed<double> Decode<double>(std::istream &, bool);
+template Decomposed<int32_t> Decode<int32_t>(std::istream &, bool);
+
+
+template void ZeroBelow<float>(Decomposed<float> &, double);
+template void ZeroBelow<double>(Decomposed<double> &, double);
+
+
+template double PreserveHighest<float>(Decomposed<float> &, double);
+template double PreserveHighest<double>(Decomposed<double> &, double);
+
+
+template double Quantize<float>(
+    Decomposed<float> &, double, std::optional<QuantizeRange>);
+
+template double Quantize<double>(
+    Decomposed<double> &, double, std::optional<QuantizeRange>);
+
+
+template double Quantize<int32_t, float>(
+    const Decomposed<float> &,
+    Decomposed<int32_t> &,
+    double,
+    std::optional<QuantizeRange>);
+
+template double Quantize<int32_t, double>(
+    const Decomposed<double> &,
+    Decomposed<int32_t> &,
+    double,
+    std::optional<QuantizeRange>);
+
+
 } // end namespace tau
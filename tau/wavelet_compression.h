@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <array>
 #include <istream>
 #include <ostream>
 #include <jive/binary_io.h>
@@ -17,7 +18,7 @@ namespace tau
 template<typename T>
 std::multiset<T> SortHighest(size_t count, const Decomposed<T> &decomposed)
 {
-    std::multiset<double> highest;
+    std::multiset<T> highest;
 
     for (const auto &row: decomposed)
     {
@@ -55,28 +56,138 @@ void WriteValue(std::ostream &output, int64_t value);
 int64_t ReadValue(uint8_t firstByte, std::istream &input);
 
 
+// The count of bytes written by WriteValue.
+size_t GetValueSize(int64_t value);
+
+
+// The count of bytes EncodeRow writes for a run of zeroCount zeros.
+size_t GetZeroRunSize(size_t zeroCount, bool enableMultibyteZeros);
+
+
+/**
+ ** The compression stage is templated on the coefficient type, so float
+ ** pipelines and quantized int32_t coefficients are coded without a round
+ ** trip through double.
+ **
+ ** The coding functions are instantiated for float, double, and int32_t.
+ ** ZeroBelow, PreserveHighest, and Quantize are instantiated for float and
+ ** double, and Quantize to int32_t from either.
+ ** Values are truncated toward zero when they are written.
+ **/
+template<typename T>
 void EncodeRow(
     std::ostream &output,
-    const Eigen::RowVector<double, Eigen::Dynamic> &row,
+    const Eigen::RowVector<T, Eigen::Dynamic> &row,
     bool enableMultibyteZeros);
 
 
+/**
+ ** Unsigned LEB128: seven bits per byte, least significant group first, with
+ ** the high bit set on every byte except the last.
+ **/
+void WriteVarint(std::ostream &output, uint64_t value);
+
+
+uint64_t ReadVarint(std::istream &input);
+
+
+size_t GetVarintSize(uint64_t value);
+
+
+/**
+ ** Group varint row layout, used when the groupVarint flag is set:
+ **
+ **     wide size (1 byte) | control bytes | value bytes
+ **
+ ** Values are zigzag encoded so that small magnitudes of either sign are small
+ ** unsigned values. Each control byte holds four 2-bit codes, first value in
+ ** the low bits, selecting 0, 1, 2, or the wide size (4 or 8) bytes for the
+ ** value. Zeros take no value bytes. Value bytes are little-endian.
+ **
+ ** The wide size is 8 only for rows holding a value that does not fit in 4
+ ** bytes.
+ **
+ ** Zeros cost two bits each instead of a shared run count, so streams are
+ ** larger than with the control byte coding, but a whole group of four values
+ ** decodes with one table lookup and no branches on the values.
+ **/
+template<typename T>
+void EncodeGroupRow(
+    std::ostream &output,
+    const Eigen::RowVector<T, Eigen::Dynamic> &row);
+
+
+template<typename T = double>
+Eigen::RowVector<T, Eigen::Dynamic> DecodeGroupRow(
+    std::istream &input,
+    size_t length);
+
+
+/**
+ ** Versioned stream layout:
+ **
+ **     magic (4 bytes) | version (1 byte) | flags (1 byte)
+ **     | row count (varint) | row lengths (varint each) | rows
+ **
+ ** The unversioned layout that preceded it begins directly with a uint8_t row
+ ** count, followed by uint16_t row lengths. The first magic byte can never be
+ ** a valid row count, so Decode can tell the layouts apart.
+ **
+ ** Version 2 added the groupVarint flag. Version 1 streams are still read.
+ **/
+namespace format
+{
+
+inline constexpr std::array<uint8_t, 4> magic{0xFF, 'T', 'W', 'C'};
+inline constexpr uint8_t version = 2;
+inline constexpr uint8_t minimumVersion = 1;
+
+// Flags
+inline constexpr uint8_t multibyteZeros = 0x01;
+inline constexpr uint8_t groupVarint = 0x02;
+
+} // end namespace format
+
+
+/**
+ ** enableGroupVarint selects the group varint row coding, which decodes
+ ** faster at some cost in size. enableMultibyteZeros only applies to the
+ ** control byte coding.
+ **/
+template<typename T>
 void Encode(
     std::ostream &output,
-    const tau::Decomposed<double> &decomposed,
-    bool enableMultibyteZeros);
+    const tau::Decomposed<T> &decomposed,
+    bool enableMultibyteZeros,
+    bool enableGroupVarint = false);
 
 
-Eigen::RowVector<double, Eigen::Dynamic> DecodeRow(
+/**
+ ** Decoding to an integer type throws if a value does not fit.
+ **/
+template<typename T = double>
+Eigen::RowVector<T, Eigen::Dynamic> DecodeRow(
     std::istream &input,
-    uint16_t length,
+    size_t length,
     bool enableMultibyteZeros);
 
 
-tau::Decomposed<double> Decode(std::istream &input, bool enableMultibyteZeros);
+/**
+ ** Reads either layout.
+ ** Versioned streams record enableMultibyteZeros in their flags, so the
+ ** argument is only used for unversioned streams.
+ **/
+template<typename T = double>
+tau::Decomposed<T> Decode(std::istream &input, bool enableMultibyteZeros);
 
 
-double PreserveHighest(Decomposed<double> &decomposed, double keepRatio);
+// Sets coefficients with magnitude less than threshold to zero.
+template<typename T>
+void ZeroBelow(Decomposed<T> &decomposed, double threshold);
+
+
+template<typename T>
+double PreserveHighest(Decomposed<T> &decomposed, double keepRatio);
 
 
 struct QuantizeRange
@@ -86,8 +197,28 @@ struct QuantizeRange
 };
 
 
+// The quantization factor Quantize uses for threshold.
+double GetQuantize(
+    double threshold,
+    std::optional<QuantizeRange> range = {});
+
+
+// Divides by the quantization factor and rounds, in place.
+template<typename T>
+double Quantize(
+    Decomposed<T> &decomposed,
+    double threshold,
+    std::optional<QuantizeRange> range = {});
+
+
+/**
+ ** Writes the quantized coefficients to an integer type, like int32_t, so they
+ ** can be held in narrower buffers. Throws if a value does not fit.
+ **/
+template<typename Integer, typename T>
 double Quantize(
-    Decomposed<double> &decomposed,
+    const Decomposed<T> &decomposed,
+    Decomposed<Integer> &quantized,
     double threshold,
     std::optional<QuantizeRange> range = {});
 
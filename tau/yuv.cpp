@@ -0,0 +1,654 @@
+#include "tau/yuv.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tau/interleave.h"
+
+
+namespace tau
+{
+
+
+namespace detail
+{
+
+
+using Index = Eigen::Index;
+
+
+// Coefficients are scaled by 2^shift.
+static constexpr int shift = 16;
+static constexpr int32_t half = 1 << (shift - 1);
+
+
+struct LumaWeights
+{
+    double red;
+    double green;
+    double blue;
+};
+
+
+LumaWeights GetLumaWeights(YuvStandard standard)
+{
+    if (standard == YuvStandard::bt709)
+    {
+        return {0.2126, 0.7152, 0.0722};
+    }
+
+    return {0.299, 0.587, 0.114};
+}
+
+
+int32_t ToFixed(double value)
+{
+    return static_cast<int32_t>(std::lround(value * (1 << shift)));
+}
+
+
+struct YuvToRgbCoefficients
+{
+    int32_t lumaFactor;
+    int32_t lumaOffset;
+    int32_t redV;
+    int32_t greenU;
+    int32_t greenV;
+    int32_t blueU;
+
+    YuvToRgbCoefficients(const YuvFormat &format)
+    {
+        auto weights = GetLumaWeights(format.standard);
+
+        double lumaScale = 1.0;
+        double chromaScale = 1.0;
+        this->lumaOffset = 0;
+
+        if (format.range == YuvRange::limited)
+        {
+            lumaScale = 255.0 / 219.0;
+            chromaScale = 255.0 / 224.0;
+            this->lumaOffset = 16;
+        }
+
+        this->lumaFactor = ToFixed(lumaScale);
+        this->redV = ToFixed(chromaScale * 2.0 * (1.0 - weights.red));
+
+        this->greenU = ToFixed(
+            chromaScale * 2.0 * weights.blue * (1.0 - weights.blue)
+            / weights.green);
+
+        this->greenV = ToFixed(
+            chromaScale * 2.0 * weights.red * (1.0 - weights.red)
+            / weights.green);
+
+        this->blueU = ToFixed(chromaScale * 2.0 * (1.0 - weights.blue));
+    }
+};
+
+
+struct RgbToYuvCoefficients
+{
+    // Rows of Y, U and V, with columns of red, green and blue.
+    int32_t y[3];
+    int32_t u[3];
+    int32_t v[3];
+    int32_t lumaOffset;
+
+    RgbToYuvCoefficients(const YuvFormat &format)
+    {
+        auto weights = GetLumaWeights(format.standard);
+
+        double lumaScale = 1.0;
+        double chromaScale = 1.0;
+        this->lumaOffset = 0;
+
+        if (format.range == YuvRange::limited)
+        {
+            lumaScale = 219.0 / 255.0;
+            chromaScale = 224.0 / 255.0;
+            this->lumaOffset = 16;
+        }
+
+        double uScale = chromaScale / (2.0 * (1.0 - weights.blue));
+        double vScale = chromaScale / (2.0 * (1.0 - weights.red));
+
+        this->y[0] = ToFixed(lumaScale * weights.red);
+        this->y[1] = ToFixed(lumaScale * weights.green);
+        this->y[2] = ToFixed(lumaScale * weights.blue);
+
+        this->u[0] = ToFixed(-uScale * weights.red);
+        this->u[1] = ToFixed(-uScale * weights.green);
+        this->u[2] = ToFixed(uScale * (1.0 - weights.blue));
+
+        this->v[0] = ToFixed(vScale * (1.0 - weights.red));
+        this->v[1] = ToFixed(-vScale * weights.green);
+        this->v[2] = ToFixed(-vScale * weights.blue);
+    }
+
+    // red, green and blue are sums of 2^sumBits pixels.
+    template<int sumBits>
+    uint8_t GetChroma(
+        const int32_t (&weights)[3],
+        int32_t red,
+        int32_t green,
+        int32_t blue) const
+    {
+        static constexpr int totalShift = shift + sumBits;
+
+        int32_t value =
+            weights[0] * red + weights[1] * green + weights[2] * blue
+            + (128 << totalShift) + (1 << (totalShift - 1));
+
+        return static_cast<uint8_t>(std::clamp(value >> totalShift, 0, 255));
+    }
+};
+
+
+// step is the pixel stride known at compile time, or 0 to read it from rgb.
+template<Index step, typename Samples>
+Index GetStep(const Samples &rgb)
+{
+    if constexpr (step == 0)
+    {
+        return rgb.pixelStride;
+    }
+    else
+    {
+        return step;
+    }
+}
+
+
+// Rows are converted in blocks of samples unpacked into local arrays, which
+// the compiler knows are not aliased, so the arithmetic is vectorized.
+static constexpr Index blockSize = 256;
+
+using Block = uint8_t[blockSize];
+
+
+/**
+ ** unpack(first, count, luma, u, v) fills the luma and chroma of each pixel
+ ** in columns [first, first + count) of one row.
+ **/
+template<Index step, typename Unpack>
+void YuvToRgbRow_(
+    const YuvToRgbCoefficients &coefficients,
+    Index width,
+    const RgbSamples<uint8_t> &rgb,
+    Index rowOffset,
+    Unpack &&unpack)
+{
+    const Index pixelStride = GetStep<step>(rgb);
+
+    const int32_t lumaFactor = coefficients.lumaFactor;
+    const int32_t lumaOffset = coefficients.lumaOffset;
+    const int32_t redV = coefficients.redV;
+    const int32_t greenU = coefficients.greenU;
+    const int32_t greenV = coefficients.greenV;
+    const int32_t blueU = coefficients.blueU;
+
+    Block luma;
+    Block u;
+    Block v;
+    Block red;
+    Block green;
+    Block blue;
+
+    for (Index first = 0; first < width; first += blockSize)
+    {
+        Index count = std::min(blockSize, width - first);
+        unpack(first, count, luma, u, v);
+
+        for (Index i = 0; i < count; ++i)
+        {
+            int32_t y = (static_cast<int32_t>(luma[i]) - lumaOffset)
+                * lumaFactor + half;
+
+            int32_t uValue = static_cast<int32_t>(u[i]) - 128;
+            int32_t vValue = static_cast<int32_t>(v[i]) - 128;
+
+            red[i] = static_cast<uint8_t>(
+                std::clamp((y + redV * vValue) >> shift, 0, 255));
+
+            green[i] = static_cast<uint8_t>(
+                std::clamp(
+                    (y - greenU * uValue - greenV * vValue) >> shift,
+                    0,
+                    255));
+
+            blue[i] = static_cast<uint8_t>(
+                std::clamp((y + blueU * uValue) >> shift, 0, 255));
+        }
+
+        Index offset = rowOffset + first * pixelStride;
+
+        if constexpr (step == 3)
+        {
+            // The samples of each pixel are adjacent, starting with red.
+            Interleave<3, uint8_t>(
+                {red, green, blue},
+                rgb.red + offset,
+                count);
+        }
+        else if constexpr (step == 1)
+        {
+            std::copy_n(red, count, rgb.red + offset);
+            std::copy_n(green, count, rgb.green + offset);
+            std::copy_n(blue, count, rgb.blue + offset);
+        }
+        else
+        {
+            for (Index i = 0; i < count; ++i)
+            {
+                rgb.red[offset + i * pixelStride] = red[i];
+                rgb.green[offset + i * pixelStride] = green[i];
+                rgb.blue[offset + i * pixelStride] = blue[i];
+            }
+        }
+    }
+}
+
+
+template<Index step>
+void Nv12ToRgbRows_(
+    const Nv12View<const uint8_t> &nv12,
+    const RgbSamples<uint8_t> &rgb,
+    const YuvToRgbCoefficients &coefficients,
+    Index firstRow,
+    Index rowCount)
+{
+    for (Index row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        const uint8_t *source = nv12.luma + row * nv12.lumaStride;
+        const uint8_t *chroma = nv12.chroma + (row / 2) * nv12.chromaStride;
+
+        YuvToRgbRow_<step>(
+            coefficients,
+            nv12.size.width,
+            rgb,
+            row * rgb.rowStride,
+            [source, chroma](
+                Index first,
+                Index count,
+                uint8_t *luma,
+                uint8_t *u,
+                uint8_t *v)
+            {
+                std::copy_n(source + first, count, luma);
+
+                // Each pair of pixels shares a U and V sample.
+                for (Index i = 0; i < count; i += 2)
+                {
+                    u[i] = u[i + 1] = chroma[first + i];
+                    v[i] = v[i + 1] = chroma[first + i + 1];
+                }
+            });
+    }
+}
+
+
+template<Index step>
+void YuyvToRgbRows_(
+    const YuyvView<const uint8_t> &yuyv,
+    const RgbSamples<uint8_t> &rgb,
+    const YuvToRgbCoefficients &coefficients,
+    Index firstRow,
+    Index rowCount)
+{
+    for (Index row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        const uint8_t *source = yuyv.data + row * yuyv.stride;
+
+        YuvToRgbRow_<step>(
+            coefficients,
+            yuyv.size.width,
+            rgb,
+            row * rgb.rowStride,
+            [source](
+                Index first,
+                Index count,
+                uint8_t *luma,
+                uint8_t *u,
+                uint8_t *v)
+            {
+                const uint8_t *pairs = source + 2 * first;
+
+                for (Index i = 0; i < count; i += 2)
+                {
+                    luma[i] = pairs[2 * i];
+                    u[i] = u[i + 1] = pairs[2 * i + 1];
+                    luma[i + 1] = pairs[2 * i + 2];
+                    v[i] = v[i + 1] = pairs[2 * i + 3];
+                }
+            });
+    }
+}
+
+
+template<Index step>
+void LoadRgbBlock_(
+    const RgbSamples<const uint8_t> &rgb,
+    Index offset,
+    Index count,
+    Block &red,
+    Block &green,
+    Block &blue)
+{
+    const Index pixelStride = GetStep<step>(rgb);
+
+    if constexpr (step == 3)
+    {
+        Deinterleave<3, uint8_t>(
+            rgb.red + offset,
+            {red, green, blue},
+            count);
+    }
+    else if constexpr (step == 1)
+    {
+        std::copy_n(rgb.red + offset, count, red);
+        std::copy_n(rgb.green + offset, count, green);
+        std::copy_n(rgb.blue + offset, count, blue);
+    }
+    else
+    {
+        for (Index i = 0; i < count; ++i)
+        {
+            red[i] = rgb.red[offset + i * pixelStride];
+            green[i] = rgb.green[offset + i * pixelStride];
+            blue[i] = rgb.blue[offset + i * pixelStride];
+        }
+    }
+}
+
+
+void GetLumaBlock(
+    const RgbToYuvCoefficients &coefficients,
+    const Block &red,
+    const Block &green,
+    const Block &blue,
+    Index count,
+    uint8_t *luma)
+{
+    const int32_t yRed = coefficients.y[0];
+    const int32_t yGreen = coefficients.y[1];
+    const int32_t yBlue = coefficients.y[2];
+    const int32_t offset = (coefficients.lumaOffset << shift) + half;
+
+    Block result;
+
+    for (Index i = 0; i < count; ++i)
+    {
+        int32_t value = yRed * red[i] + yGreen * green[i] + yBlue * blue[i]
+            + offset;
+
+        result[i] = static_cast<uint8_t>(std::clamp(value >> shift, 0, 255));
+    }
+
+    std::copy_n(result, count, luma);
+}
+
+
+template<Index step>
+void RgbToNv12Rows_(
+    const RgbSamples<const uint8_t> &rgb,
+    const Nv12View<uint8_t> &nv12,
+    const RgbToYuvCoefficients &coefficients,
+    Index firstRow,
+    Index rowCount)
+{
+    const Index pixelStride = GetStep<step>(rgb);
+    const Index width = nv12.size.width;
+
+    Block red;
+    Block green;
+    Block blue;
+    Block nextRed;
+    Block nextGreen;
+    Block nextBlue;
+    Block chroma;
+
+    for (Index row = firstRow; row < firstRow + rowCount; row += 2)
+    {
+        uint8_t *luma = nv12.luma + row * nv12.lumaStride;
+        uint8_t *nextLuma = luma + nv12.lumaStride;
+        uint8_t *chromaRow = nv12.chroma + (row / 2) * nv12.chromaStride;
+
+        Index rowOffset = row * rgb.rowStride;
+
+        for (Index first = 0; first < width; first += blockSize)
+        {
+            Index count = std::min(blockSize, width - first);
+            Index offset = rowOffset + first * pixelStride;
+
+            LoadRgbBlock_<step>(rgb, offset, count, red, green, blue);
+
+            LoadRgbBlock_<step>(
+                rgb,
+                offset + rgb.rowStride,
+                count,
+                nextRed,
+                nextGreen,
+                nextBlue);
+
+            GetLumaBlock(coefficients, red, green, blue, count, luma + first);
+
+            GetLumaBlock(
+                coefficients,
+                nextRed,
+                nextGreen,
+                nextBlue,
+                count,
+                nextLuma + first);
+
+            // U and V of each 2 x 2 block, from the sums of its samples.
+            for (Index i = 0; i < count; i += 2)
+            {
+                int32_t redSum = red[i] + red[i + 1]
+                    + nextRed[i] + nextRed[i + 1];
+
+                int32_t greenSum = green[i] + green[i + 1]
+                    + nextGreen[i] + nextGreen[i + 1];
+
+                int32_t blueSum = blue[i] + blue[i + 1]
+                    + nextBlue[i] + nextBlue[i + 1];
+
+                chroma[i] = coefficients.GetChroma<2>(
+                    coefficients.u,
+                    redSum,
+                    greenSum,
+                    blueSum);
+
+                chroma[i + 1] = coefficients.GetChroma<2>(
+                    coefficients.v,
+                    redSum,
+                    greenSum,
+                    blueSum);
+            }
+
+            std::copy_n(chroma, count, chromaRow + first);
+        }
+    }
+}
+
+
+template<Index step>
+void RgbToYuyvRows_(
+    const RgbSamples<const uint8_t> &rgb,
+    const YuyvView<uint8_t> &yuyv,
+    const RgbToYuvCoefficients &coefficients,
+    Index firstRow,
+    Index rowCount)
+{
+    const Index pixelStride = GetStep<step>(rgb);
+    const Index width = yuyv.size.width;
+
+    Block red;
+    Block green;
+    Block blue;
+    Block luma;
+    uint8_t pairs[2 * blockSize];
+
+    for (Index row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        uint8_t *target = yuyv.data + row * yuyv.stride;
+        Index rowOffset = row * rgb.rowStride;
+
+        for (Index first = 0; first < width; first += blockSize)
+        {
+            Index count = std::min(blockSize, width - first);
+
+            LoadRgbBlock_<step>(
+                rgb,
+                rowOffset + first * pixelStride,
+                count,
+                red,
+                green,
+                blue);
+
+            GetLumaBlock(coefficients, red, green, blue, count, luma);
+
+            for (Index i = 0; i < count; i += 2)
+            {
+                int32_t redSum = red[i] + red[i + 1];
+                int32_t greenSum = green[i] + green[i + 1];
+                int32_t blueSum = blue[i] + blue[i + 1];
+
+                pairs[2 * i] = luma[i];
+
+                pairs[2 * i + 1] = coefficients.GetChroma<1>(
+                    coefficients.u,
+                    redSum,
+                    greenSum,
+                    blueSum);
+
+                pairs[2 * i + 2] = luma[i + 1];
+
+                pairs[2 * i + 3] = coefficients.GetChroma<1>(
+                    coefficients.v,
+                    redSum,
+                    greenSum,
+                    blueSum);
+            }
+
+            std::copy_n(pairs, 2 * count, target + 2 * first);
+        }
+    }
+}
+
+
+// Interleaved pixels and planes get loops with a constant pixel stride.
+template<typename Samples, typename Function>
+void DispatchStep(const Samples &rgb, Function &&function)
+{
+    if (rgb.pixelStride == 3)
+    {
+        function(std::integral_constant<Index, 3>{});
+    }
+    else if (rgb.pixelStride == 1)
+    {
+        function(std::integral_constant<Index, 1>{});
+    }
+    else
+    {
+        function(std::integral_constant<Index, 0>{});
+    }
+}
+
+
+void Nv12ToRgbRows(
+    const Nv12View<const uint8_t> &nv12,
+    const RgbSamples<uint8_t> &rgb,
+    const YuvFormat &format,
+    Index firstRow,
+    Index rowCount)
+{
+    YuvToRgbCoefficients coefficients(format);
+
+    DispatchStep(
+        rgb,
+        [&](auto step)
+        {
+            Nv12ToRgbRows_<decltype(step)::value>(
+                nv12,
+                rgb,
+                coefficients,
+                firstRow,
+                rowCount);
+        });
+}
+
+
+void YuyvToRgbRows(
+    const YuyvView<const uint8_t> &yuyv,
+    const RgbSamples<uint8_t> &rgb,
+    const YuvFormat &format,
+    Index firstRow,
+    Index rowCount)
+{
+    YuvToRgbCoefficients coefficients(format);
+
+    DispatchStep(
+        rgb,
+        [&](auto step)
+        {
+            YuyvToRgbRows_<decltype(step)::value>(
+                yuyv,
+                rgb,
+                coefficients,
+                firstRow,
+                rowCount);
+        });
+}
+
+
+void RgbToNv12Rows(
+    const RgbSamples<const uint8_t> &rgb,
+    const Nv12View<uint8_t> &nv12,
+    const YuvFormat &format,
+    Index firstRow,
+    Index rowCount)
+{
+    RgbToYuvCoefficients coefficients(format);
+
+    DispatchStep(
+        rgb,
+        [&](auto step)
+        {
+            RgbToNv12Rows_<decltype(step)::value>(
+                rgb,
+                nv12,
+                coefficients,
+                firstRow,
+                rowCount);
+        });
+}
+
+
+void RgbToYuyvRows(
+    const RgbSamples<const uint8_t> &rgb,
+    const YuyvView<uint8_t> &yuyv,
+    const YuvFormat &format,
+    Index firstRow,
+    Index rowCount)
+{
+    RgbToYuvCoefficients coefficients(format);
+
+    DispatchStep(
+        rgb,
+        [&](auto step)
+        {
+            RgbToYuyvRows_<decltype(step)::value>(
+                rgb,
+                yuyv,
+                coefficients,
+                firstRow,
+                rowCount);
+        });
+}
+
+
+} // end namespace detail
+
+
+} // end namespace tau
@@ -0,0 +1,436 @@
+#pragma once
+
+
+#include <cstdint>
+#include <stdexcept>
+#include <fields/fields.h>
+
+#include "tau/eigen.h"
+#include "tau/size.h"
+#include "tau/color.h"
+#include "tau/row_bands.h"
+
+
+namespace tau
+{
+
+
+enum class YuvStandard
+{
+    bt601,
+    bt709
+};
+
+
+enum class YuvRange
+{
+    // Luma and chroma use every value from 0 to 255.
+    full,
+
+    // Luma from 16 to 235, and chroma from 16 to 240, as video is usually
+    // delivered.
+    limited
+};
+
+
+struct YuvFormat
+{
+    YuvStandard standard;
+    YuvRange range;
+
+    static constexpr auto fields = std::make_tuple(
+        fields::Field(&YuvFormat::standard, "standard"),
+        fields::Field(&YuvFormat::range, "range"));
+};
+
+
+/**
+ ** An 8-bit NV12 frame in memory owned by the caller: a luma plane at full
+ ** resolution, and a plane of interleaved U and V samples with one pair for
+ ** each 2 x 2 block of pixels. Strides are in bytes. Use a const T to view
+ ** frames that are only read.
+ **/
+template<typename T>
+struct Nv12View
+{
+    static_assert(std::is_same_v<std::remove_const_t<T>, uint8_t>);
+
+    using Index = Eigen::Index;
+
+    T *luma;
+    T *chroma;
+    Size<Index> size;
+    Index lumaStride;
+    Index chromaStride;
+
+    // A frame packed without padding, with the chroma plane after the luma.
+    static Nv12View Create(T *buffer, const Size<Index> &size)
+    {
+        return {
+            buffer,
+            buffer + size.width * size.height,
+            size,
+            size.width,
+            size.width};
+    }
+
+    static Index GetByteCount(const Size<Index> &size)
+    {
+        return size.width * size.height + size.width * (size.height / 2);
+    }
+};
+
+
+/**
+ ** An 8-bit YUYV (YUY2) frame in memory owned by the caller. Each pair of
+ ** pixels in a row is stored as Y0 U Y1 V. stride is in bytes.
+ **/
+template<typename T>
+struct YuyvView
+{
+    static_assert(std::is_same_v<std::remove_const_t<T>, uint8_t>);
+
+    using Index = Eigen::Index;
+
+    T *data;
+    Size<Index> size;
+    Index stride;
+
+    static YuyvView Create(T *buffer, const Size<Index> &size)
+    {
+        return {buffer, size, 2 * size.width};
+    }
+
+    static Index GetByteCount(const Size<Index> &size)
+    {
+        return 2 * size.width * size.height;
+    }
+};
+
+
+/**
+ ** 8-bit RGB samples written or read by the YUV conversions.
+ **
+ ** red, green, and blue point to the first sample of each channel.
+ ** pixelStride is 3 for interleaved pixels and 1 for planes. rowStride is
+ ** the count of samples between rows.
+ **/
+template<typename T>
+struct RgbSamples
+{
+    using Index = Eigen::Index;
+
+    T *red;
+    T *green;
+    T *blue;
+    Index pixelStride;
+    Index rowStride;
+};
+
+
+namespace detail
+{
+
+
+void Nv12ToRgbRows(
+    const Nv12View<const uint8_t> &nv12,
+    const RgbSamples<uint8_t> &rgb,
+    const YuvFormat &format,
+    Eigen::Index firstRow,
+    Eigen::Index rowCount);
+
+
+void YuyvToRgbRows(
+    const YuyvView<const uint8_t> &yuyv,
+    const RgbSamples<uint8_t> &rgb,
+    const YuvFormat &format,
+    Eigen::Index firstRow,
+    Eigen::Index rowCount);
+
+
+// firstRow and rowCount are even, so each band holds whole rows of chroma.
+void RgbToNv12Rows(
+    const RgbSamples<const uint8_t> &rgb,
+    const Nv12View<uint8_t> &nv12,
+    const YuvFormat &format,
+    Eigen::Index firstRow,
+    Eigen::Index rowCount);
+
+
+void RgbToYuyvRows(
+    const RgbSamples<const uint8_t> &rgb,
+    const YuyvView<uint8_t> &yuyv,
+    const YuvFormat &format,
+    Eigen::Index firstRow,
+    Eigen::Index rowCount);
+
+
+inline void RequireEvenSize(const Size<Eigen::Index> &size)
+{
+    if (size.width % 2 != 0 || size.height % 2 != 0)
+    {
+        throw std::invalid_argument("NV12 requires an even width and height");
+    }
+}
+
+
+inline void RequireEvenWidth(const Size<Eigen::Index> &size)
+{
+    if (size.width % 2 != 0)
+    {
+        throw std::invalid_argument("YUYV requires an even width");
+    }
+}
+
+
+template<typename Pixels>
+auto GetRgbSamples(Pixels &pixels)
+{
+    using T = std::remove_pointer_t<decltype(pixels.data.data())>;
+
+    static_assert(std::is_same_v<std::remove_const_t<T>, uint8_t>);
+    static_assert(std::remove_reference_t<decltype(pixels.data)>::IsRowMajor);
+
+    if (pixels.data.rows() != pixels.size.width * pixels.size.height)
+    {
+        throw std::invalid_argument("pixels must match their size");
+    }
+
+    T *data = pixels.data.data();
+
+    return RgbSamples<T>{data, data + 1, data + 2, 3, 3 * pixels.size.width};
+}
+
+
+template<typename T, int rows, int columns, int options>
+auto GetRgbSamples(Planar<3, T, rows, columns, options> &planar)
+{
+    static_assert(options & Eigen::RowMajor, "Expected row-major planes");
+
+    return RgbSamples<T>{
+        planar.planes[0].data(),
+        planar.planes[1].data(),
+        planar.planes[2].data(),
+        1,
+        planar.GetColumnCount()};
+}
+
+
+template<typename T, int rows, int columns, int options>
+auto GetRgbSamples(const Planar<3, T, rows, columns, options> &planar)
+{
+    static_assert(options & Eigen::RowMajor, "Expected row-major planes");
+
+    return RgbSamples<const T>{
+        planar.planes[0].data(),
+        planar.planes[1].data(),
+        planar.planes[2].data(),
+        1,
+        planar.GetColumnCount()};
+}
+
+
+template<typename Rgb>
+Size<Eigen::Index> GetRgbSize(const Rgb &rgb)
+{
+    if constexpr (IsPlanar<Rgb>)
+    {
+        return {{rgb.GetColumnCount(), rgb.GetRowCount()}};
+    }
+    else
+    {
+        return rgb.size;
+    }
+}
+
+
+template<typename Rgb>
+void RequireSize(const Rgb &rgb, const Size<Eigen::Index> &size)
+{
+    auto rgbSize = GetRgbSize(rgb);
+
+    if (rgbSize.width != size.width || rgbSize.height != size.height)
+    {
+        throw std::invalid_argument("rgb must match the size of the frame");
+    }
+}
+
+
+} // end namespace detail
+
+
+/**
+ ** Converts 8-bit YUV frames to and from RGB in fixed point.
+ **
+ ** rgb may be RgbPixels<uint8_t>, an RgbPixelsView<uint8_t>, or a row-major
+ ** Planar<3, uint8_t>, already sized to match the frame; nothing is
+ ** allocated. The overloads that take a ThreadPool convert bands of rows in
+ ** parallel. Each sample is within one count of the exact conversion.
+ **
+ ** RGB to NV12 averages the chroma of each 2 x 2 block, and RGB to YUYV the
+ ** chroma of each pair of pixels.
+ **/
+template<typename Rgb>
+void Nv12ToRgb(
+    const Nv12View<const uint8_t> &nv12,
+    Rgb &rgb,
+    const YuvFormat &format)
+{
+    detail::RequireEvenSize(nv12.size);
+    detail::RequireSize(rgb, nv12.size);
+
+    detail::Nv12ToRgbRows(
+        nv12,
+        detail::GetRgbSamples(rgb),
+        format,
+        0,
+        nv12.size.height);
+}
+
+
+template<typename Rgb>
+void Nv12ToRgb(
+    const Nv12View<const uint8_t> &nv12,
+    Rgb &rgb,
+    const YuvFormat &format,
+    ThreadPool &threadPool)
+{
+    detail::RequireEvenSize(nv12.size);
+    detail::RequireSize(rgb, nv12.size);
+    auto samples = detail::GetRgbSamples(rgb);
+
+    ForEachRowBand(
+        nv12.size.height,
+        threadPool,
+        [&](Eigen::Index firstRow, Eigen::Index rowCount)
+        {
+            detail::Nv12ToRgbRows(nv12, samples, format, firstRow, rowCount);
+        });
+}
+
+
+template<typename Rgb>
+void YuyvToRgb(
+    const YuyvView<const uint8_t> &yuyv,
+    Rgb &rgb,
+    const YuvFormat &format)
+{
+    detail::RequireEvenWidth(yuyv.size);
+    detail::RequireSize(rgb, yuyv.size);
+
+    detail::YuyvToRgbRows(
+        yuyv,
+        detail::GetRgbSamples(rgb),
+        format,
+        0,
+        yuyv.size.height);
+}
+
+
+template<typename Rgb>
+void YuyvToRgb(
+    const YuyvView<const uint8_t> &yuyv,
+    Rgb &rgb,
+    const YuvFormat &format,
+    ThreadPool &threadPool)
+{
+    detail::RequireEvenWidth(yuyv.size);
+    detail::RequireSize(rgb, yuyv.size);
+    auto samples = detail::GetRgbSamples(rgb);
+
+    ForEachRowBand(
+        yuyv.size.height,
+        threadPool,
+        [&](Eigen::Index firstRow, Eigen::Index rowCount)
+        {
+            detail::YuyvToRgbRows(yuyv, samples, format, firstRow, rowCount);
+        });
+}
+
+
+template<typename Rgb>
+void RgbToNv12(
+    const Rgb &rgb,
+    const Nv12View<uint8_t> &nv12,
+    const YuvFormat &format)
+{
+    detail::RequireEvenSize(nv12.size);
+    detail::RequireSize(rgb, nv12.size);
+
+    detail::RgbToNv12Rows(
+        detail::GetRgbSamples(rgb),
+        nv12,
+        format,
+        0,
+        nv12.size.height);
+}
+
+
+template<typename Rgb>
+void RgbToNv12(
+    const Rgb &rgb,
+    const Nv12View<uint8_t> &nv12,
+    const YuvFormat &format,
+    ThreadPool &threadPool)
+{
+    detail::RequireEvenSize(nv12.size);
+    detail::RequireSize(rgb, nv12.size);
+    auto samples = detail::GetRgbSamples(rgb);
+
+    // Bands are made of pairs of rows that share chroma.
+    ForEachRowBand(
+        nv12.size.height / 2,
+        threadPool,
+        [&](Eigen::Index firstPair, Eigen::Index pairCount)
+        {
+            detail::RgbToNv12Rows(
+                samples,
+                nv12,
+                format,
+                2 * firstPair,
+                2 * pairCount);
+        },
+        8);
+}
+
+
+template<typename Rgb>
+void RgbToYuyv(
+    const Rgb &rgb,
+    const YuyvView<uint8_t> &yuyv,
+    const YuvFormat &format)
+{
+    detail::RequireEvenWidth(yuyv.size);
+    detail::RequireSize(rgb, yuyv.size);
+
+    detail::RgbToYuyvRows(
+        detail::GetRgbSamples(rgb),
+        yuyv,
+        format,
+        0,
+        yuyv.size.height);
+}
+
+
+template<typename Rgb>
+void RgbToYuyv(
+    const Rgb &rgb,
+    const YuyvView<uint8_t> &yuyv,
+    const YuvFormat &format,
+    ThreadPool &threadPool)
+{
+    detail::RequireEvenWidth(yuyv.size);
+    detail::RequireSize(rgb, yuyv.size);
+    auto samples = detail::GetRgbSamples(rgb);
+
+    ForEachRowBand(
+        yuyv.size.height,
+        threadPool,
+        [&](Eigen::Index firstRow, Eigen::Index rowCount)
+        {
+            detail::RgbToYuyvRows(samples, yuyv, format, firstRow, rowCount);
+        });
+}
+
+
+} // end namespace tau
@@ -0,0 +1,381 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <tau/bayer.h>
+#include <tau/mono_image.h>
+#include <tau/random.h>
+
+
+namespace
+{
+
+
+using Index = Eigen::Index;
+using Kernel = Eigen::Matrix<int32_t, 5, 5>;
+
+
+enum class Site
+{
+    red,
+    green,
+    blue
+};
+
+
+Site GetSite(tau::BayerPattern pattern, Index row, Index column)
+{
+    // The colors of the top-left 2 x 2 block.
+    static const char *names[] = {"rggb", "bggr", "grbg", "gbrg"};
+    char name = names[static_cast<int>(pattern)][2 * (row % 2) + column % 2];
+
+    if (name == 'r')
+    {
+        return Site::red;
+    }
+
+    if (name == 'b')
+    {
+        return Site::blue;
+    }
+
+    return Site::green;
+}
+
+
+// The kernels of each method, scaled by 16.
+struct Kernels
+{
+    Kernel green;
+    Kernel beside;
+    Kernel aboveBelow;
+    Kernel opposite;
+
+    Kernels(tau::DemosaicMethod method)
+    {
+        if (method == tau::DemosaicMethod::malvarHeCutler)
+        {
+            this->green <<
+                 0,  0, -2,  0,  0,
+                 0,  0,  4,  0,  0,
+                -2,  4,  8,  4, -2,
+                 0,  0,  4,  0,  0,
+                 0,  0, -2,  0,  0;
+
+            this->beside <<
+                 0,  0,  1,  0,  0,
+                 0, -2,  0, -2,  0,
+                -2,  8, 10,  8, -2,
+                 0, -2,  0, -2,  0,
+                 0,  0,  1,  0,  0;
+
+            this->opposite <<
+                 0,  0, -3,  0,  0,
+                 0,  4,  0,  4,  0,
+                -3,  0, 12,  0, -3,
+                 0,  4,  0,  4,  0,
+                 0,  0, -3,  0,  0;
+        }
+        else
+        {
+            this->green <<
+                 0,  0,  0,  0,  0,
+                 0,  0,  4,  0,  0,
+                 0,  4,  0,  4,  0,
+                 0,  0,  4,  0,  0,
+                 0,  0,  0,  0,  0;
+
+            this->beside <<
+                 0,  0,  0,  0,  0,
+                 0,  0,  0,  0,  0,
+                 0,  8,  0,  8,  0,
+                 0,  0,  0,  0,  0,
+                 0,  0,  0,  0,  0;
+
+            this->opposite <<
+                 0,  0,  0,  0,  0,
+                 0,  4,  0,  4,  0,
+                 0,  0,  0,  0,  0,
+                 0,  4,  0,  4,  0,
+                 0,  0,  0,  0,  0;
+        }
+
+        this->aboveBelow = this->beside.transpose();
+    }
+};
+
+
+Index Mirror(Index index, Index count)
+{
+    if (index < 0)
+    {
+        return -index;
+    }
+
+    if (index >= count)
+    {
+        return 2 * (count - 1) - index;
+    }
+
+    return index;
+}
+
+
+// Applies each 5 x 5 kernel directly, one pixel at a time.
+template<typename T>
+tau::BayerPlanar<T> ReferenceDemosaic(
+    const tau::MonoImage<T> &bayer,
+    const tau::DemosaicSettings &settings)
+{
+    Kernels kernels(settings.method);
+    auto maximum = (1 << settings.bitDepth) - 1;
+    auto rows = bayer.rows();
+    auto columns = bayer.cols();
+
+    Eigen::MatrixX<int32_t> extended(rows + 4, columns + 4);
+
+    for (Index row = 0; row < rows + 4; ++row)
+    {
+        for (Index column = 0; column < columns + 4; ++column)
+        {
+            extended(row, column) = bayer(
+                Mirror(row - 2, rows),
+                Mirror(column - 2, columns));
+        }
+    }
+
+    tau::BayerPlanar<T> result(rows, columns);
+
+    for (Index row = 0; row < rows; ++row)
+    {
+        for (Index column = 0; column < columns; ++column)
+        {
+            Kernel neighbors = extended.block<5, 5>(row, column);
+
+            auto apply = [&](const Kernel &kernel)
+            {
+                int32_t sum = neighbors.cwiseProduct(kernel).sum();
+
+                return static_cast<T>(
+                    std::clamp((sum + 8) >> 4, 0, maximum));
+            };
+
+            auto value = static_cast<T>(neighbors(2, 2));
+            auto &red = result.planes[0](row, column);
+            auto &green = result.planes[1](row, column);
+            auto &blue = result.planes[2](row, column);
+
+            auto site = GetSite(settings.pattern, row, column);
+
+            if (site == Site::red)
+            {
+                red = value;
+                green = apply(kernels.green);
+                blue = apply(kernels.opposite);
+            }
+            else if (site == Site::blue)
+            {
+                red = apply(kernels.opposite);
+                green = apply(kernels.green);
+                blue = value;
+            }
+            else
+            {
+                green = value;
+
+                auto next = GetSite(settings.pattern, row, column + 1);
+
+                if (next == Site::red)
+                {
+                    red = apply(kernels.beside);
+                    blue = apply(kernels.aboveBelow);
+                }
+                else
+                {
+                    red = apply(kernels.aboveBelow);
+                    blue = apply(kernels.beside);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+
+template<typename T>
+tau::MonoImage<T> MakeRandomMosaic(
+    unsigned seed,
+    Index rows,
+    Index columns,
+    int bitDepth)
+{
+    auto uniformRandom =
+        tau::UniformRandom<int>(seed, 0, (1 << bitDepth) - 1);
+
+    tau::MonoImage<T> result(rows, columns);
+
+    for (auto &sample: result.reshaped())
+    {
+        sample = static_cast<T>(uniformRandom());
+    }
+
+    return result;
+}
+
+
+template<typename T>
+void RequireEqual(
+    const tau::BayerPlanar<T> &first,
+    const tau::BayerPlanar<T> &second)
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(first.planes[i] == second.planes[i]);
+    }
+}
+
+
+} // end anonymous namespace
+
+
+TEST_CASE("Demosaic matches the kernels at every pattern", "[bayer]")
+{
+    auto seed = GENERATE(take(2, random(0u, 10000u)));
+
+    auto pattern = GENERATE(
+        tau::BayerPattern::rggb,
+        tau::BayerPattern::bggr,
+        tau::BayerPattern::grbg,
+        tau::BayerPattern::gbrg);
+
+    auto method = GENERATE(
+        tau::DemosaicMethod::bilinear,
+        tau::DemosaicMethod::malvarHeCutler);
+
+    // Wider than one block of columns.
+    Index rows = 10;
+    Index columns = 300;
+
+    SECTION("8-bit")
+    {
+        tau::DemosaicSettings settings{pattern, method, 8};
+        auto bayer = MakeRandomMosaic<uint8_t>(seed, rows, columns, 8);
+
+        RequireEqual(
+            tau::Demosaic(bayer, settings),
+            ReferenceDemosaic(bayer, settings));
+    }
+
+    SECTION("12-bit")
+    {
+        tau::DemosaicSettings settings{pattern, method, 12};
+        auto bayer = MakeRandomMosaic<uint16_t>(seed, rows, columns, 12);
+        auto rgb = tau::Demosaic(bayer, settings);
+
+        RequireEqual(rgb, ReferenceDemosaic(bayer, settings));
+
+        for (auto &plane: rgb.planes)
+        {
+            REQUIRE(plane.maxCoeff() <= 4095);
+        }
+    }
+}
+
+
+TEST_CASE("Demosaic restores a uniform color", "[bayer]")
+{
+    auto method = GENERATE(
+        tau::DemosaicMethod::bilinear,
+        tau::DemosaicMethod::malvarHeCutler);
+
+    tau::DemosaicSettings settings{tau::BayerPattern::grbg, method, 16};
+    Index rows = 6;
+    Index columns = 8;
+    tau::MonoImage<uint16_t> bayer(rows, columns);
+
+    uint16_t color[] = {40000, 1234, 65535};
+
+    for (Index row = 0; row < rows; ++row)
+    {
+        for (Index column = 0; column < columns; ++column)
+        {
+            bayer(row, column) = color[
+                static_cast<int>(GetSite(settings.pattern, row, column))];
+        }
+    }
+
+    auto rgb = tau::Demosaic(bayer, settings);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE((rgb.planes[i].array() == color[i]).all());
+    }
+}
+
+
+TEST_CASE("Demosaic reads strided buffers and row bands", "[bayer]")
+{
+    auto seed = GENERATE(take(3, random(0u, 10000u)));
+    tau::ThreadPool threadPool(4);
+
+    tau::DemosaicSettings settings{
+        tau::BayerPattern::bggr,
+        tau::DemosaicMethod::malvarHeCutler,
+        10};
+
+    Index rows = 70;
+    Index columns = 64;
+    Index stride = 80;
+
+    // A frame buffer with padding at the end of each row.
+    auto buffer = MakeRandomMosaic<uint16_t>(seed, rows, stride, 10);
+
+    Eigen::Map<const tau::MonoImage<uint16_t>, 0, Eigen::OuterStride<>> bayer(
+        buffer.data(),
+        rows,
+        columns,
+        Eigen::OuterStride<>(stride));
+
+    tau::MonoImage<uint16_t> copied = bayer;
+    auto expected = tau::Demosaic(copied, settings);
+
+    RequireEqual(tau::Demosaic(bayer, settings), expected);
+    RequireEqual(tau::Demosaic(bayer, settings, threadPool), expected);
+
+    // Planes that already have the size are reused.
+    tau::BayerPlanar<uint16_t> rgb(rows, columns);
+    auto red = rgb.planes[0].data();
+    tau::Demosaic(bayer, rgb, settings, threadPool);
+    REQUIRE(rgb.planes[0].data() == red);
+    RequireEqual(rgb, expected);
+}
+
+
+TEST_CASE("Demosaic rejects unsupported mosaics", "[bayer]")
+{
+    tau::DemosaicSettings settings{
+        tau::BayerPattern::rggb,
+        tau::DemosaicMethod::bilinear,
+        8};
+
+    tau::MonoImage<uint8_t> oddWidth = tau::MonoImage<uint8_t>::Zero(6, 7);
+    tau::MonoImage<uint8_t> flat = tau::MonoImage<uint8_t>::Zero(2, 8);
+    tau::MonoImage<uint8_t> bytes = tau::MonoImage<uint8_t>::Zero(4, 4);
+    tau::MonoImage<uint16_t> words = tau::MonoImage<uint16_t>::Zero(4, 4);
+
+    REQUIRE_THROWS_AS(
+        tau::Demosaic(oddWidth, settings),
+        std::invalid_argument);
+
+    REQUIRE_THROWS_AS(
+        tau::Demosaic(flat, settings),
+        std::invalid_argument);
+
+    settings.bitDepth = 9;
+
+    REQUIRE_THROWS_AS(
+        tau::Demosaic(bytes, settings),
+        std::invalid_argument);
+
+    REQUIRE_NOTHROW(tau::Demosaic(words, settings));
+}
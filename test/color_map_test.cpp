@@ -1,9 +1,15 @@
 #include <catch2/catch.hpp>
 
+#include <array>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <vector>
 #include "jive/range.h"
 #include "turbo_matrix.h"
 #include "tau/color_maps/turbo.h"
 #include "tau/color_map.h"
+#include "tau/percentile.h"
 
 
 TEST_CASE("Test standard turbo color map.", "[tau]")
@@ -209,3 +215,619 @@ TEST_CASE("Unravel a matrix", "[tau]")
         REQUIRE(all[i] == i);
     }
 }
+
+
+TEST_CASE("ColorMap filters a caller's buffers in place", "[tau]")
+{
+    tau::ColorMapSettings<int32_t> settings;
+    settings.range.low = 10;
+    settings.range.high = 200;
+
+    auto colorMap = tau::ColorMap<int32_t>(settings);
+
+    std::vector<int32_t> frame(6 * 5);
+
+    for (size_t i = 0; i < frame.size(); ++i)
+    {
+        frame[i] = static_cast<int32_t>(i * 9) - 20;
+    }
+
+    Eigen::Map<const tau::MonoImage<int32_t>> input(frame.data(), 5, 6);
+
+    auto expected = colorMap.Filter(tau::MonoImage<int32_t>(input));
+
+    std::vector<uint8_t> display(frame.size() * 3);
+    bool isReleased = false;
+
+    auto pixels = tau::RgbPixelsView<uint8_t>::CreateShared(
+        display.data(),
+        {6, 5},
+        [&](uint8_t *buffer)
+        {
+            REQUIRE(buffer == display.data());
+            isReleased = true;
+        });
+
+    colorMap.Filter(input, *pixels);
+
+    REQUIRE(pixels->data == expected.data);
+    REQUIRE(display[3 * 29 + 2] == expected.data(29, 2));
+
+    auto copy = pixels;
+    pixels.reset();
+    REQUIRE(!isReleased);
+
+    copy.reset();
+    REQUIRE(isReleased);
+
+    auto wrongSize = tau::RgbPixelsView<uint8_t>::Create(
+        display.data(),
+        {5, 6});
+
+    REQUIRE_THROWS_AS(
+        colorMap.Filter(input, wrongSize),
+        std::invalid_argument);
+}
+
+
+TEST_CASE("ColorMap compares other input types with its range", "[tau]")
+{
+    tau::ColorMapSettings<int32_t> settings;
+    settings.range.low = -10;
+    settings.range.high = 200;
+
+    auto colorMap = tau::ColorMap<int32_t>(settings);
+
+    std::vector<uint16_t> frame{0, 5, 190, 200, 300, 65535};
+    Eigen::Map<const tau::MonoImage<uint16_t>> input(frame.data(), 2, 3);
+
+    auto expected =
+        colorMap.Filter(tau::MonoImage<int32_t>(input.cast<int32_t>()));
+
+    auto pixels = tau::RgbPixels<uint8_t>{
+        tau::RgbPixels<uint8_t>::Data(input.size(), 3),
+        {3, 2}};
+
+    colorMap.Filter(input, pixels);
+
+    REQUIRE(pixels.data == expected.data);
+
+    // Values below -10 and NaN take the first color.
+    auto colors = tau::turbo::MakeRgb8(211).eval();
+    auto limited = tau::LimitedColorMap(colors, int32_t{-10}, int32_t{200});
+
+    Eigen::RowVectorXf values(4);
+    values << std::numeric_limits<float>::quiet_NaN(), -1e30f, -4.5f, 1e30f;
+
+    tau::RgbPixels<uint8_t>::Data mapped;
+    limited(values, &mapped);
+
+    REQUIRE(mapped.row(0) == colors.row(0));
+    REQUIRE(mapped.row(1) == colors.row(0));
+    REQUIRE(mapped.row(2) == colors.row(5));
+    REQUIRE(mapped.row(3) == colors.row(210));
+}
+
+
+TEMPLATE_TEST_CASE(
+    "PackedColorMap matches LimitedColorMap",
+    "[tau]",
+    uint8_t,
+    uint16_t,
+    int32_t)
+{
+    using Value = TestType;
+
+    auto colors = tau::turbo::MakeRgb8(91).eval();
+    auto limited = tau::LimitedColorMap(colors, Value{20}, Value{110});
+    auto packed = tau::PackedColorMap<Value>(limited);
+
+    tau::MonoImage<Value> input(7, 40);
+
+    for (Eigen::Index i = 0; i < input.size(); ++i)
+    {
+        // Reaches past both ends of the range.
+        input.data()[i] = static_cast<Value>(i % 131);
+    }
+
+    tau::RgbPixels<uint8_t>::Data expected;
+    limited(input, &expected);
+
+    std::vector<uint32_t> buffer(static_cast<size_t>(input.size()));
+    Eigen::Map<tau::MonoImage<uint32_t>> output(buffer.data(), 7, 40);
+
+    packed(input, &output);
+
+    std::vector<uint8_t> bytes(buffer.size() * 4);
+    std::memcpy(bytes.data(), buffer.data(), bytes.size());
+
+    for (Eigen::Index i = 0; i < input.size(); ++i)
+    {
+        auto pixel = static_cast<size_t>(4 * i);
+        REQUIRE(bytes[pixel] == expected(i, 0));
+        REQUIRE(bytes[pixel + 1] == expected(i, 1));
+        REQUIRE(bytes[pixel + 2] == expected(i, 2));
+        REQUIRE(bytes[pixel + 3] == 255);
+    }
+
+    tau::MonoImage<uint32_t> wrongSize(40, 7);
+
+    REQUIRE_THROWS_AS(packed(input, &wrongSize), std::invalid_argument);
+}
+
+
+TEST_CASE("ColorMap writes packed RGBA", "[tau]")
+{
+    tau::ColorMapSettings<int32_t> settings;
+    settings.range.low = 10;
+    settings.range.high = 200;
+
+    auto colorMap = tau::ColorMap<int32_t>(settings);
+
+    tau::MonoImage<int32_t> input(5, 6);
+    input.reshaped<Eigen::RowMajor>().setLinSpaced(-20, 250);
+
+    auto expected = colorMap.Filter(input);
+
+    tau::MonoImage<uint32_t> packed(5, 6);
+    colorMap.FilterPacked(input, &packed);
+
+    for (Eigen::Index i = 0; i < packed.size(); ++i)
+    {
+        std::array<uint8_t, 4> bytes;
+        std::memcpy(bytes.data(), packed.data() + i, 4);
+
+        REQUIRE(bytes[0] == expected.data(i, 0));
+        REQUIRE(bytes[1] == expected.data(i, 1));
+        REQUIRE(bytes[2] == expected.data(i, 2));
+        REQUIRE(bytes[3] == 255);
+    }
+}
+
+
+TEST_CASE("ColorMap maps row bands in parallel", "[tau]")
+{
+    tau::ColorMapSettings<int32_t> settings;
+    settings.range.low = 10;
+    settings.range.high = 200;
+
+    auto colorMap = tau::ColorMap<int32_t>(settings);
+    tau::ThreadPool threadPool(4);
+
+    auto rowCount = GENERATE(1, 17, 100, 131);
+
+    tau::MonoImage<int32_t> input(rowCount, 37);
+    input.reshaped<Eigen::RowMajor>().setLinSpaced(-20, 250);
+
+    auto expected = colorMap.Filter(input);
+    auto parallel = colorMap.Filter(input, threadPool);
+
+    REQUIRE(parallel.data == expected.data);
+
+    tau::MonoImage<uint32_t> expectedPacked(rowCount, 37);
+    colorMap.FilterPacked(input, &expectedPacked);
+
+    tau::MonoImage<uint32_t> packed(rowCount, 37);
+    colorMap.FilterPacked(input, &packed, threadPool);
+
+    REQUIRE(packed == expectedPacked);
+
+    auto scaledColorMap =
+        tau::ScaledColorMap(tau::turbo::MakeRgb8(8).eval(), -20, 250);
+
+    tau::RgbPixels<uint8_t>::Data scaledExpected;
+    scaledColorMap(input, &scaledExpected);
+
+    tau::RgbPixels<uint8_t>::Data scaled(input.size(), 3);
+    tau::MapRowBands(scaledColorMap, input, &scaled, threadPool);
+
+    REQUIRE(scaled == scaledExpected);
+}
+
+
+TEST_CASE("Threads share one ColorMap", "[tau]")
+{
+    auto colorMap =
+        tau::ColorMap<int32_t>(tau::ColorMapSettings<int32_t>());
+
+    tau::ThreadPool threadPool(4);
+
+    tau::MonoImage<int32_t> input(64, 48);
+    input.reshaped<Eigen::RowMajor>().setLinSpaced(0, 255);
+
+    auto expected = colorMap.Filter(input);
+
+    std::vector<std::future<bool>> streams;
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        streams.push_back(
+            std::async(
+                std::launch::async,
+                [&]()
+                {
+                    bool matches = true;
+
+                    for (size_t frame = 0; frame < 20; ++frame)
+                    {
+                        matches = matches
+                            && colorMap.Filter(input, threadPool).data
+                                == expected.data;
+                    }
+
+                    return matches;
+                }));
+    }
+
+    for (auto &stream: streams)
+    {
+        REQUIRE(stream.get());
+    }
+}
+
+
+TEMPLATE_TEST_CASE(
+    "ScaledColorMap rescales integral values in one pass",
+    "[tau]",
+    uint8_t,
+    int16_t,
+    uint16_t,
+    int32_t)
+{
+    using Value = TestType;
+
+    auto turbo = tau::turbo::MakeRgb8(37).eval();
+    Value minimum = 3;
+    Value maximum = 120;
+
+    auto scaledColorMap = tau::ScaledColorMap(turbo, minimum, maximum);
+
+    tau::MonoImage<Value> input(3, 50);
+
+    for (Eigen::Index i = 0; i < input.size(); ++i)
+    {
+        input.data()[i] = static_cast<Value>(i - 10);
+    }
+
+    tau::RgbPixels<uint8_t>::Data mapped;
+    scaledColorMap(input, &mapped);
+
+    for (Eigen::Index i = 0; i < input.size(); ++i)
+    {
+        // Round half up in exact arithmetic.
+        auto offset = std::clamp<int64_t>(input.data()[i], 3, 120) - 3;
+        auto index = (2 * offset * 36 + 117) / (2 * 117);
+
+        REQUIRE(mapped.row(i) == turbo.row(index));
+    }
+}
+
+
+TEST_CASE("FixedRescale multiplies and shifts exactly", "[tau]")
+{
+    auto count = GENERATE(2, 3, 256, 1000, 4096);
+    auto minimum = GENERATE(-1000, 0, 7);
+    auto maximum = GENERATE(1, 1023, 65535, 262143);
+
+    if (maximum <= minimum)
+    {
+        return;
+    }
+
+    auto rescale = tau::FixedRescale<int32_t>(count, minimum, maximum);
+    int64_t range = maximum - minimum;
+
+    auto largestNumerator = 2 * range * (count - 1) + range;
+    REQUIRE(rescale.IsFast() == (largestNumerator < (int64_t{1} << 31)));
+
+    for (int64_t value = minimum; value <= maximum; ++value)
+    {
+        auto offset = value - minimum;
+        auto expected = (2 * offset * (count - 1) + range) / (2 * range);
+
+        REQUIRE(rescale.GetIndex(static_cast<int32_t>(value)) == expected);
+    }
+}
+
+
+TEST_CASE("FixedRescale divides wide ranges", "[tau]")
+{
+    auto rescale = tau::FixedRescale<int32_t>(
+        256,
+        std::numeric_limits<int32_t>::lowest(),
+        std::numeric_limits<int32_t>::max());
+
+    REQUIRE(!rescale.IsFast());
+    REQUIRE(rescale.GetIndex(std::numeric_limits<int32_t>::lowest()) == 0);
+    REQUIRE(rescale.GetIndex(std::numeric_limits<int32_t>::max()) == 255);
+    REQUIRE(rescale.GetIndex(0) == 128);
+}
+
+
+TEST_CASE("FixedRescale clamps 64-bit values", "[tau]")
+{
+    auto rescale = tau::FixedRescale<int32_t>(256, -100, 100);
+
+    REQUIRE(rescale.GetIndex(std::numeric_limits<uint64_t>::max()) == 255);
+    REQUIRE(rescale.GetIndex(std::numeric_limits<int64_t>::lowest()) == 0);
+    REQUIRE(rescale.GetIndex(std::numeric_limits<int64_t>::max()) == 255);
+    REQUIRE(rescale.GetIndex(uint64_t{100}) == 255);
+}
+
+
+TEST_CASE("ScaledColorMap rescales 64-bit bounds", "[tau]")
+{
+    auto turbo = tau::turbo::MakeRgb8(256).eval();
+    tau::RgbPixels<uint8_t>::Data mapped;
+
+    SECTION("int64_t")
+    {
+        int64_t maximum = int64_t{1} << 62;
+        auto scaledColorMap = tau::ScaledColorMap(turbo, int64_t{0}, maximum);
+
+        tau::MonoImage<int64_t> input(1, 5);
+
+        input << std::numeric_limits<int64_t>::lowest(),
+            0,
+            maximum / 2,
+            maximum,
+            std::numeric_limits<int64_t>::max();
+
+        scaledColorMap(input, &mapped);
+
+        REQUIRE(mapped.row(0) == turbo.row(0));
+        REQUIRE(mapped.row(1) == turbo.row(0));
+        REQUIRE(mapped.row(2) == turbo.row(128));
+        REQUIRE(mapped.row(3) == turbo.row(255));
+        REQUIRE(mapped.row(4) == turbo.row(255));
+    }
+
+    SECTION("uint64_t")
+    {
+        uint64_t minimum = uint64_t{1} << 63;
+        uint64_t maximum = std::numeric_limits<uint64_t>::max();
+        auto scaledColorMap = tau::ScaledColorMap(turbo, minimum, maximum);
+
+        tau::MonoImage<uint64_t> input(1, 3);
+        input << 0, minimum, maximum;
+
+        scaledColorMap(input, &mapped);
+
+        REQUIRE(mapped.row(0) == turbo.row(0));
+        REQUIRE(mapped.row(1) == turbo.row(0));
+        REQUIRE(mapped.row(2) == turbo.row(255));
+    }
+}
+
+
+TEST_CASE("ColorMaps share cached palettes", "[tau]")
+{
+    auto &cache = tau::PaletteCache::Get();
+
+    // Exact where the count of colors divides the master.
+    REQUIRE(*cache.GetPalette(true, 256) == tau::turbo::MakeRgb8(256));
+    REQUIRE(*cache.GetPalette(false, 256) == tau::gray::MakeRgb8(256));
+
+    REQUIRE(
+        *cache.GetPalette(true, tau::PaletteCache::masterCount)
+        == tau::turbo::MakeRgb8(tau::PaletteCache::masterCount));
+
+    // Otherwise within one step of the evaluated map.
+    auto turbo = cache.GetPalette(true, 191);
+    auto evaluated = tau::turbo::MakeRgb8(191).cast<int>().eval();
+
+    REQUIRE(
+        (turbo->cast<int>() - evaluated).cwiseAbs().maxCoeff() <= 1);
+
+    REQUIRE(cache.GetPalette(true, 191) == turbo);
+
+    REQUIRE_THROWS_AS(cache.GetPalette(true, 1), std::invalid_argument);
+
+    tau::ColorMapSettings<int32_t> settings;
+    settings.turbo = true;
+    settings.range.low = 10;
+    settings.range.high = 200;
+
+    auto colorMap = tau::MakeColorMap<tau::RgbPixels<uint8_t>>(settings);
+    REQUIRE(&colorMap.GetColors() == turbo.get());
+}
+
+
+TEST_CASE("PaletteCache keeps the most recently used palettes", "[tau]")
+{
+    tau::PaletteCache cache(2);
+
+    auto first = cache.GetPalette(true, 10);
+    auto second = cache.GetPalette(true, 11);
+
+    // Use first again, so that second is the oldest.
+    REQUIRE(cache.GetPalette(true, 10) == first);
+
+    cache.GetPalette(false, 10);
+    REQUIRE(cache.GetSize() == 2);
+    REQUIRE(cache.GetPalette(true, 10) == first);
+
+    auto regenerated = cache.GetPalette(true, 11);
+    REQUIRE(regenerated != second);
+    REQUIRE(*regenerated == *second);
+}
+
+
+TEST_CASE("QuantizedColorMap maps floating-point values", "[tau]")
+{
+    auto colorMap = tau::QuantizedColorMap<float>(true, -1.5f, 2.5f, 256);
+    const auto &colors = colorMap.GetColors();
+
+    REQUIRE(colors.rows() == 256);
+
+    tau::MonoImage<float> input(2, 4);
+
+    input <<
+        -1.5f, 2.5f, -10.0f, 100.0f,
+        0.5f, std::numeric_limits<float>::quiet_NaN(), -1.49f, 2.49f;
+
+    auto pixels = colorMap.Filter(input);
+
+    REQUIRE(pixels.size.width == 4);
+    REQUIRE(pixels.size.height == 2);
+
+    std::vector<Eigen::Index> expected{0, 255, 0, 255, 128, 0, 1, 254};
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        REQUIRE(
+            pixels.data.row(static_cast<Eigen::Index>(i))
+            == colors.row(expected[i]));
+    }
+}
+
+
+TEST_CASE("QuantizedColorMap maps wide integral ranges", "[tau]")
+{
+    tau::ColorMapSettings<int32_t> settings;
+    settings.turbo = false;
+    settings.range.low = std::numeric_limits<int32_t>::lowest();
+    settings.range.high = std::numeric_limits<int32_t>::max();
+
+    auto colorMap = tau::QuantizedColorMap<int32_t>(settings);
+
+    REQUIRE(colorMap.GetColors().rows() == 4096);
+    REQUIRE(colorMap.GetIndex(std::numeric_limits<int32_t>::lowest()) == 0);
+    REQUIRE(colorMap.GetIndex(std::numeric_limits<int32_t>::max()) == 4095);
+    REQUIRE(colorMap.GetIndex(0) == 2048);
+
+    tau::MonoImage<int32_t> input(40, 30);
+    input.reshaped<Eigen::RowMajor>().setLinSpaced(-2000000000, 2000000000);
+
+    tau::ThreadPool threadPool(3);
+    auto expected = colorMap.Filter(input);
+    auto pixels =
+        tau::RgbPixels<uint8_t>::Create(tau::Size<Eigen::Index>(30, 40));
+    colorMap.Filter(input, pixels, threadPool);
+
+    REQUIRE(pixels.data == expected.data);
+}
+
+
+TEST_CASE("Diverging palette meets in white at zero", "[tau]")
+{
+    auto palette = tau::diverging::MakeRgb8(4);
+
+    REQUIRE(palette.rows() == 9);
+    REQUIRE(palette.row(0) == tau::RgbMatrix<uint8_t>{{0, 0, 255}});
+    REQUIRE(palette.row(4) == tau::RgbMatrix<uint8_t>{{255, 255, 255}});
+    REQUIRE(palette.row(8) == tau::RgbMatrix<uint8_t>{{255, 0, 0}});
+}
+
+
+TEMPLATE_TEST_CASE(
+    "DivergingColorMap maps signed values symmetrically",
+    "[tau]",
+    int16_t,
+    int32_t,
+    float)
+{
+    using Value = TestType;
+
+    auto colorMap = tau::DivergingColorMap<Value>::FromRange(-100, 60, 10);
+    const auto &palette = colorMap.GetColors();
+
+    REQUIRE(palette.rows() == 21);
+
+    tau::MonoImage<Value> input(2, 5);
+    input << -1000, -100, -55, -5, 0, 4, 5, 55, 100, 1000;
+
+    // Halves round away from zero, symmetrically.
+    std::vector<Eigen::Index> expected{0, 0, 4, 9, 10, 10, 11, 16, 20, 20};
+
+    auto pixels = colorMap.Filter(input);
+    tau::MonoImage<uint32_t> packed(2, 5);
+    colorMap.FilterPacked(input, &packed);
+
+    for (Eigen::Index i = 0; i < input.size(); ++i)
+    {
+        auto index = expected[static_cast<size_t>(i)];
+        REQUIRE(colorMap.GetIndex(input.data()[i]) == index);
+        REQUIRE(pixels.data.row(i) == palette.row(index));
+
+        std::array<uint8_t, 4> bytes;
+        std::memcpy(bytes.data(), packed.data() + i, 4);
+
+        REQUIRE(bytes[0] == palette(index, 0));
+        REQUIRE(bytes[1] == palette(index, 1));
+        REQUIRE(bytes[2] == palette(index, 2));
+        REQUIRE(bytes[3] == 255);
+    }
+}
+
+
+TEST_CASE("DivergingColorMap covers every 16-bit value", "[tau]")
+{
+    auto colorMap = tau::DivergingColorMap<int16_t>(32768.0f);
+
+    tau::MonoImage<int16_t> input(256, 256);
+
+    input.reshaped<Eigen::RowMajor>() =
+        Eigen::VectorX<int32_t>::LinSpaced(65536, -32768, 32767)
+            .cast<int16_t>();
+
+    auto pixels = colorMap.Filter(input);
+    tau::MonoImage<uint32_t> packed(256, 256);
+    colorMap.FilterPacked(input, &packed);
+
+    for (Eigen::Index i = 0; i < input.size(); ++i)
+    {
+        auto index = colorMap.GetIndex(input.data()[i]);
+        REQUIRE(pixels.data.row(i) == colorMap.GetColors().row(index));
+
+        REQUIRE(
+            packed.data()[i]
+            == tau::detail::PackRgba(colorMap.GetColors(), index));
+    }
+
+    REQUIRE(colorMap.GetIndex(-32768) == 0);
+    REQUIRE(colorMap.GetIndex(0) == 256);
+
+    REQUIRE(
+        tau::DivergingColorMap<float>(1.0f).GetIndex(
+            std::numeric_limits<float>::quiet_NaN()) == 256);
+}
+
+
+TEST_CASE("AutoRangeColorMap follows the percentiles of frames", "[tau]")
+{
+    auto autoRangeSettings = tau::AutoRangeSettings::Default();
+    autoRangeSettings.binCount = 4096;
+
+    auto colorMap = tau::AutoRangeColorMap<int32_t>(
+        tau::ColorMapSettings<int32_t>(),
+        autoRangeSettings,
+        0,
+        4095);
+
+    tau::MonoImage<int32_t> frame(50, 40);
+    frame.reshaped<Eigen::RowMajor>().setLinSpaced(1000, 2999);
+
+    auto pixels = colorMap.Filter(frame);
+
+    REQUIRE(colorMap.GetRebuildCount() == 1);
+
+    auto &settings = colorMap.GetColorMapSettings();
+    REQUIRE(settings.range.low == tau::Percentile(frame, 0.01));
+    REQUIRE(settings.range.high == tau::Percentile(frame, 0.99));
+    REQUIRE(pixels.data == colorMap.GetColorMap()->Filter(frame).data);
+
+    // A small drift keeps the map.
+    auto first = colorMap.GetColorMap();
+    frame.array() += 20;
+    colorMap.Filter(frame);
+
+    REQUIRE(colorMap.GetRebuildCount() == 1);
+    REQUIRE(colorMap.GetColorMap() == first);
+
+    frame.array() += 500;
+    colorMap.Filter(frame);
+
+    REQUIRE(colorMap.GetRebuildCount() == 2);
+    REQUIRE(settings.range.low == tau::Percentile(frame, 0.01));
+}
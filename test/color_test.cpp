@@ -3,6 +3,7 @@
 #include <jive/range.h>
 #include "tau/planar.h"
 #include "tau/color.h"
+#include "tau/random.h"
 
 
 static constexpr size_t channels = 3;
@@ -310,3 +311,161 @@ TEST_CASE("HasAlpha", "[color]")
     STATIC_REQUIRE(tau::HasAlpha<tau::Hsva<double>>);
     STATIC_REQUIRE(!tau::HasAlpha<tau::Hsv<double>>);
 }
+
+
+TEMPLATE_TEST_CASE(
+    "Planar RGB to HSV matches each pixel",
+    "[color]",
+    uint8_t,
+    uint16_t)
+{
+    using Rgba = tau::Planar
+        <
+            4,
+            TestType,
+            Eigen::Dynamic,
+            Eigen::Dynamic,
+            Eigen::RowMajor
+        >;
+
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    // A coarse range of levels makes ties between the channels common.
+    auto random = tau::UniformRandom<int>(seed, 0, 8);
+    auto step = std::numeric_limits<TestType>::max() / 8;
+
+    // More pixels than one conversion block, with a partial block at the end.
+    Rgba rgba(19, 37);
+
+    for (auto &plane: rgba.planes)
+    {
+        for (auto i: jive::Range<Eigen::Index>(0, rgba.GetRowCount()))
+        {
+            for (auto j: jive::Range<Eigen::Index>(0, rgba.GetColumnCount()))
+            {
+                plane(i, j) = static_cast<TestType>(random() * step);
+            }
+        }
+    }
+
+    auto hsva = tau::RgbToHsv<float>(rgba);
+
+    for (auto i: jive::Range<Eigen::Index>(0, rgba.GetRowCount()))
+    {
+        for (auto j: jive::Range<Eigen::Index>(0, rgba.GetColumnCount()))
+        {
+            Eigen::Vector4f expected =
+                tau::RgbToHsv<float>(rgba.GetVector(i, j));
+
+            // The Vector overload computes the hue modulo in double.
+            REQUIRE(hsva.GetVector(i, j).isApprox(expected, 1e-6f));
+        }
+    }
+}
+
+
+TEST_CASE("HsvLookup is within its documented error", "[color]")
+{
+    using Rgba = tau::Planar
+        <
+            4,
+            uint8_t,
+            Eigen::Dynamic,
+            Eigen::Dynamic,
+            Eigen::RowMajor
+        >;
+
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto random = tau::UniformRandom<int>(seed, 0, 255);
+
+    Rgba rgba(23, 29);
+
+    for (auto &plane: rgba.planes)
+    {
+        for (auto i: jive::Range<Eigen::Index>(0, rgba.GetRowCount()))
+        {
+            for (auto j: jive::Range<Eigen::Index>(0, rgba.GetColumnCount()))
+            {
+                plane(i, j) = static_cast<uint8_t>(random());
+            }
+        }
+    }
+
+    // Include the gray and primary colors, where ties decide the hue.
+    tau::GetRed(rgba).row(0).head(4) << 0, 255, 0, 200;
+    tau::GetGreen(rgba).row(0).head(4) << 0, 0, 255, 200;
+    tau::GetBlue(rgba).row(0).head(4) << 0, 0, 255, 200;
+
+    const auto &lookup = tau::HsvLookup::Get();
+    auto expected = tau::RgbToHsv<double>(rgba);
+    auto hsva = lookup.RgbToHsv<double>(rgba);
+
+    for (size_t plane = 0; plane < 4; ++plane)
+    {
+        REQUIRE(
+            (hsva.planes[plane] - expected.planes[plane])
+                .cwiseAbs().maxCoeff() <= 0.001 + 1e-9);
+    }
+
+    auto recovered = lookup.HsvToRgb(hsva);
+    auto expectedRgba = tau::HsvToRgb<uint8_t>(hsva);
+
+    for (size_t plane = 0; plane < 4; ++plane)
+    {
+        Eigen::MatrixXi difference =
+            recovered.planes[plane].cast<int>()
+                - expectedRgba.planes[plane].cast<int>();
+
+        REQUIRE(difference.cwiseAbs().maxCoeff() <= 1);
+    }
+
+    // Converting the alpha plane is exact.
+    REQUIRE(recovered.planes[3] == rgba.planes[3]);
+
+    // Components out of range, or NaN, are clamped.
+    auto nan = std::numeric_limits<double>::quiet_NaN();
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+
+    lookup.HsvToRgb(nan, 1.0, 1.0, red, green, blue);
+    REQUIRE((red == 255 && green == 0 && blue == 0));
+
+    lookup.HsvToRgb(-30.0, 2.0, 1.5, red, green, blue);
+    REQUIRE((red == 255 && green == 0 && blue == 0));
+
+    lookup.HsvToRgb(400.0, 1.0, 1.0, red, green, blue);
+    REQUIRE((red == 255 && green == 0 && blue == 0));
+
+    lookup.HsvToRgb(120.0, nan, -1.0, red, green, blue);
+    REQUIRE((red == 0 && green == 0 && blue == 0));
+
+    lookup.HsvToRgb(240.0, -0.5, nan, red, green, blue);
+    REQUIRE((red == 0 && green == 0 && blue == 0));
+
+    lookup.HsvToRgb(240.0, 0.0, 7.0, red, green, blue);
+    REQUIRE((red == 255 && green == 255 && blue == 255));
+}
+
+
+TEST_CASE("Pixels copies every byte of wide samples", "[color]")
+{
+    std::vector<uint16_t> samples(4 * 3 * 2);
+
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        samples[i] = static_cast<uint16_t>(1000 + i);
+    }
+
+    auto pixels = tau::RgbaPixels<uint16_t>::Create({3, 2}, samples.data());
+
+    REQUIRE(pixels.data(5, 3) == samples.back());
+
+    auto view = tau::RgbaPixelsView<uint16_t>::Create(samples.data(), {3, 2});
+
+    REQUIRE(view.data == pixels.data);
+    REQUIRE(view.GetPlanar().planes == pixels.GetPlanar().planes);
+}
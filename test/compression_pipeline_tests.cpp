@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <tau/compression_pipeline.h>
+#include "wavelet_signal.h"
+
+
+Eigen::RowVector<double, Eigen::Dynamic> MakeLongTestSignal(
+    tau::Seed seed,
+    Eigen::Index repeatCount)
+{
+    using Eigen::seqN;
+
+    Eigen::RowVector<double, Eigen::Dynamic> result(1024 * repeatCount);
+
+    for (Eigen::Index i = 0; i < repeatCount; ++i)
+    {
+        result(seqN(i * 1024, 1024)) =
+            MakeTestSignal(seed + static_cast<tau::Seed>(i));
+    }
+
+    return result;
+}
+
+
+TEST_CASE("Parallel compression matches serial compression", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max() / 2)));
+
+    auto signal = MakeLongTestSignal(seed, 9);
+
+    auto settings = tau::CompressionSettings::Default();
+    settings.segmentLength = 1000;
+    settings.maximumPending = 3;
+
+    tau::ThreadPool serialPool(1);
+    tau::ThreadPool parallelPool(4);
+
+    std::ostringstream serial;
+    std::ostringstream parallel;
+
+    tau::CompressSegments(serial, signal, settings, serialPool);
+    tau::CompressSegments(parallel, signal, settings, parallelPool);
+
+    REQUIRE(serial.str() == parallel.str());
+}
+
+
+TEST_CASE("Compressed segments round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max() / 2)));
+
+    auto signal = MakeLongTestSignal(seed, 5);
+
+    auto settings = tau::CompressionSettings::Default();
+    settings.keepRatio = 1.0;
+    settings.segmentLength = GENERATE(777, 1024, 5000);
+    settings.enableGroupVarint = GENERATE(false, true);
+
+    tau::ThreadPool threadPool(4);
+    std::stringstream stream;
+
+    tau::CompressSegments(stream, signal, settings, threadPool);
+    auto recovered = tau::DecompressSegments(stream, threadPool);
+
+    REQUIRE(recovered.size() == signal.size());
+
+    // Keeping every coefficient leaves only the quantization error.
+    REQUIRE(tau::GetRms(recovered - signal) < 1.0);
+}
+
+
+TEST_CASE("Segment with a corrupt sample count is rejected", "[wavelet]")
+{
+    auto settings = tau::CompressionSettings::Default();
+    auto wavelet = tau::GetWavelet<double>(settings.wavelet);
+    auto signal = MakeTestSignal(7);
+
+    auto chunk = tau::CompressSegment(wavelet, signal, settings);
+
+    // The chunk begins with its sample count.
+    std::string corrupt = chunk;
+    std::fill_n(corrupt.begin(), 4, '\xFF');
+
+    std::istringstream input(corrupt);
+
+    REQUIRE_THROWS_AS(
+        tau::DecompressSegment(
+            wavelet,
+            input,
+            settings.reflect,
+            settings.enableMultibyteZeros),
+        std::runtime_error);
+
+    std::istringstream valid(chunk);
+
+    REQUIRE(
+        tau::DecompressSegment(
+            wavelet,
+            valid,
+            settings.reflect,
+            settings.enableMultibyteZeros).size() == signal.size());
+}
+
@@ -0,0 +1,149 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+#include "tau/color.h"
+#include "tau/color_map.h"
+#include "tau/frame_pool.h"
+#include "tau/mono_image.h"
+
+
+TEST_CASE("FramePool recycles frames", "[frame_pool]")
+{
+    using Pool = tau::FramePool<tau::RgbPixels<uint8_t>>;
+
+    auto pool = Pool::Create({640, 480}, 2);
+
+    auto first = pool->Acquire();
+    auto second = pool->Acquire();
+
+    REQUIRE(first->size.width == 640);
+    REQUIRE(first->data.rows() == 640 * 480);
+
+    auto firstData = first->data.data();
+
+    first.reset();
+    second.reset();
+
+    auto counts = pool->GetCounts();
+    REQUIRE(counts.hitCount == 0);
+    REQUIRE(counts.missCount == 2);
+    REQUIRE(counts.recycledCount == 2);
+
+    auto third = pool->Acquire();
+    auto fourth = pool->Acquire();
+    auto fifth = pool->Acquire();
+
+    REQUIRE(
+        (third->data.data() == firstData
+         || fourth->data.data() == firstData));
+
+    counts = pool->GetCounts();
+    REQUIRE(counts.hitCount == 2);
+    REQUIRE(counts.missCount == 3);
+
+    third.reset();
+    fourth.reset();
+    fifth.reset();
+
+    // The pool holds only two frames.
+    REQUIRE(pool->GetCounts().discardedCount == 1);
+
+    // Frames outlive their pool.
+    auto survivor = pool->Acquire();
+    pool.reset();
+    survivor->data.setZero();
+    survivor.reset();
+}
+
+
+TEST_CASE("FramePool is safe to share between threads", "[frame_pool]")
+{
+    using Pool = tau::FramePool<tau::MonoImage<uint16_t>>;
+
+    auto pool = Pool::Create({32, 16}, 4);
+    std::vector<std::thread> threads;
+
+    static constexpr size_t iterationCount = 2000;
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        threads.emplace_back(
+            [pool, i]()
+            {
+                for (size_t j = 0; j < iterationCount; ++j)
+                {
+                    auto frame = pool->Acquire();
+                    auto value = static_cast<uint16_t>(i);
+                    frame->setConstant(value);
+
+                    // No other thread holds this frame.
+                    if ((frame->array() != value).any())
+                    {
+                        throw std::logic_error("frame is shared");
+                    }
+                }
+            });
+    }
+
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+
+    auto counts = pool->GetCounts();
+
+    REQUIRE(counts.hitCount + counts.missCount == 4 * iterationCount);
+    REQUIRE(counts.recycledCount + counts.discardedCount == 4 * iterationCount);
+    REQUIRE(counts.missCount <= 4 + counts.discardedCount);
+}
+
+
+TEST_CASE("FramePools keeps a pool for each size", "[frame_pool]")
+{
+    tau::FramePools<tau::MonoImage<float>> pools;
+
+    auto small = pools.Get({4, 3});
+    REQUIRE(pools.Get({4, 3}) == small);
+    REQUIRE(pools.Get({3, 4}) != small);
+
+    auto frame = pools.Acquire({3, 4});
+    REQUIRE(frame->rows() == 4);
+    REQUIRE(frame->cols() == 3);
+
+    frame.reset();
+    pools.Acquire({3, 4});
+
+    auto counts = pools.GetCounts();
+    REQUIRE(counts.hitCount == 1);
+    REQUIRE(counts.missCount == 1);
+}
+
+
+TEST_CASE("ColorMap filters into pooled frames", "[frame_pool]")
+{
+    using Pixels = tau::RgbPixels<uint8_t>;
+
+    auto colorMap = tau::ColorMap<int32_t>(tau::ColorMapSettings<int32_t>());
+    auto pool = tau::FramePool<Pixels>::Create({8, 2});
+
+    tau::MonoImage<int32_t> data(2, 8);
+    data.row(0).setLinSpaced(0, 255);
+    data.row(1).setConstant(100);
+
+    auto expected = colorMap.Filter(data);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto pixels = colorMap.Filter(data, *pool);
+        REQUIRE(pixels->data == expected.data);
+    }
+
+    REQUIRE(pool->GetCounts().missCount == 1);
+
+    tau::MonoImage<int32_t> wrongSize(3, 8);
+
+    REQUIRE_THROWS_AS(
+        colorMap.Filter(wrongSize, *pool),
+        std::invalid_argument);
+}
@@ -0,0 +1,85 @@
+#include <catch2/catch.hpp>
+
+#include <tau/histogram.h>
+#include <tau/percentile.h>
+#include <tau/random.h>
+
+
+TEST_CASE("StreamingHistogram matches Percentile with unit bins", "[histogram]")
+{
+    auto seed = GENERATE(take(3, random(0u, 10000u)));
+    auto uniformRandom = tau::UniformRandom<int>(seed, -300, 700);
+
+    Eigen::MatrixX<int> frame(37, 23);
+
+    for (Eigen::Index i = 0; i < frame.size(); ++i)
+    {
+        frame.data()[i] = uniformRandom();
+    }
+
+    // One bin for each value from -300 to 700.
+    tau::StreamingHistogram<int> histogram(-300, 700, 1001);
+    histogram.AddFrame(frame);
+
+    REQUIRE(histogram.GetTotal() == static_cast<double>(frame.size()));
+
+    for (auto percentile: {0.0, 0.01, 0.25, 0.5, 0.9, 0.99})
+    {
+        REQUIRE(
+            histogram.GetPercentile(percentile)
+            == tau::Percentile(frame, percentile));
+    }
+}
+
+
+TEST_CASE("StreamingHistogram bins span the range", "[histogram]")
+{
+    tau::StreamingHistogram<int> histogram(0, 999, 7);
+
+    for (size_t bin = 0; bin < 7; ++bin)
+    {
+        auto value = histogram.GetBinValue(bin);
+
+        // value is the smallest value in bin.
+        REQUIRE(histogram.GetBin(value) == bin);
+
+        if (bin > 0)
+        {
+            REQUIRE(histogram.GetBin(value - 1) == bin - 1);
+        }
+    }
+
+    REQUIRE(histogram.GetBin(-50) == 0);
+    REQUIRE(histogram.GetBin(5000) == 6);
+}
+
+
+TEST_CASE("StreamingHistogram forgets earlier frames", "[histogram]")
+{
+    Eigen::VectorX<float> low = Eigen::VectorX<float>::Constant(100, 1.0f);
+    Eigen::VectorX<float> high = Eigen::VectorX<float>::Constant(100, 9.0f);
+
+    tau::StreamingHistogram<float> latest(0.0f, 10.0f, 100);
+    latest.AddFrame(low);
+    latest.AddFrame(high);
+
+    REQUIRE(latest.GetTotal() == 100.0);
+    REQUIRE(latest.GetPercentile(0.01) == Approx(9.0f));
+
+    tau::StreamingHistogram<float> decaying(0.0f, 10.0f, 100, 0.5);
+    decaying.AddFrame(low);
+    decaying.AddFrame(high);
+
+    REQUIRE(decaying.GetTotal() == 150.0);
+
+    // A third of the weight is from the first frame.
+    REQUIRE(decaying.GetPercentile(0.3) == Approx(1.0f));
+    REQUIRE(decaying.GetPercentile(0.4) == Approx(9.0f));
+
+    Eigen::VectorX<float> nan = Eigen::VectorX<float>::Constant(
+        10,
+        std::numeric_limits<float>::quiet_NaN());
+
+    decaying.AddFrame(nan);
+    REQUIRE(decaying.GetTotal() == 75.0);
+}
@@ -0,0 +1,162 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <tau/image_codec.h>
+#include <tau/random.h>
+#include <tau/wavelet2d.h>
+
+
+using Image = tau::MonoImage<uint16_t>;
+
+
+// A smooth gradient with a bright square and some noise.
+Image MakeTestImage(tau::Seed seed, Eigen::Index rows, Eigen::Index columns)
+{
+    auto random = tau::UniformRandom<double>(seed, -20.0, 20.0);
+    Image result(rows, columns);
+
+    for (Eigen::Index row = 0; row < rows; ++row)
+    {
+        for (Eigen::Index column = 0; column < columns; ++column)
+        {
+            double value = 1000.0 + 30.0 * static_cast<double>(row + column);
+
+            if (row > rows / 3 && row < rows / 2 && column > columns / 4)
+            {
+                value += 20000.0;
+            }
+
+            result(row, column) = static_cast<uint16_t>(value + random());
+        }
+    }
+
+    return result;
+}
+
+
+double GetMaximumError(const Image &left, const Image &right)
+{
+    return (left.cast<double>() - right.cast<double>())
+        .array().abs().maxCoeff();
+}
+
+
+TEST_CASE("2D decomposition round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto waveletName = GENERATE(
+        tau::WaveletName::db1,
+        tau::WaveletName::db2,
+        tau::WaveletName::db5);
+
+    auto rows = GENERATE(37, 64);
+    auto columns = GENERATE(50, 81);
+
+    auto wavelet = tau::GetWavelet<double>(waveletName);
+    tau::MonoImage<double> image = MakeTestImage(seed, rows, columns)
+        .cast<double>();
+
+    auto decomposed = tau::Decompose2d(wavelet, image, true);
+
+    REQUIRE(!decomposed.details.empty());
+
+    auto recomposed = tau::Recompose2d(wavelet, decomposed, true);
+
+    REQUIRE(recomposed.rows() == rows);
+    REQUIRE(recomposed.cols() == columns);
+    REQUIRE(recomposed.isApprox(image));
+}
+
+
+TEST_CASE("Image codec round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto settings = tau::ImageCodecSettings::Default();
+    settings.keepRatio = 1.0;
+    settings.tileSize = GENERATE(32, 64, 500);
+    settings.enableGroupVarint = GENERATE(false, true);
+
+    auto image = MakeTestImage(seed, 150, 97);
+    tau::ThreadPool threadPool(4);
+
+    std::stringstream stream;
+    tau::EncodeImage(stream, image, settings, threadPool);
+    auto decoded = tau::DecodeImage(stream, threadPool);
+
+    REQUIRE(decoded.rows() == image.rows());
+    REQUIRE(decoded.cols() == image.cols());
+
+    // Keeping every coefficient leaves only the quantization error.
+    REQUIRE(GetMaximumError(decoded, image) <= 2.0);
+}
+
+
+TEST_CASE("Image codec decodes a region", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto settings = tau::ImageCodecSettings::Default();
+    settings.tileSize = 32;
+
+    auto image = MakeTestImage(seed, 150, 97);
+    tau::ThreadPool threadPool(4);
+
+    std::ostringstream output;
+    tau::EncodeImage(output, image, settings, threadPool);
+
+    std::istringstream wholeInput(output.str());
+    auto whole = tau::DecodeImage(wholeInput, threadPool);
+
+    tau::IntRegion region{};
+    region.topLeft = {GENERATE(0, 40), GENERATE(0, 33)};
+    region.size = {GENERATE(1, 30, 200), GENERATE(17, 64)};
+
+    std::istringstream regionInput(output.str());
+    auto partial = tau::DecodeImage(regionInput, region, threadPool);
+
+    // The region is clipped to the image.
+    auto columns = std::min(region.size.width, 97 - region.topLeft.x);
+    auto rows = std::min(region.size.height, 150 - region.topLeft.y);
+
+    REQUIRE(partial.rows() == rows);
+    REQUIRE(partial.cols() == columns);
+
+    Image expected =
+        whole.block(region.topLeft.y, region.topLeft.x, rows, columns);
+
+    REQUIRE(partial == expected);
+}
+
+
+TEST_CASE("Image codec round trip of planar frames", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto settings = tau::ImageCodecSettings::Default();
+    settings.keepRatio = 1.0;
+    settings.tileSize = 48;
+
+    tau::PlanarImage<3, Eigen::ColMajor> planar(100, 70);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        planar.planes[i] =
+            MakeTestImage(seed + static_cast<tau::Seed>(i), 100, 70);
+    }
+
+    tau::ThreadPool threadPool(4);
+    std::stringstream stream;
+    tau::EncodePlanar(stream, planar, settings, threadPool);
+    auto decoded = tau::DecodePlanar<3>(stream, threadPool);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(GetMaximumError(decoded.planes[i], planar.planes[i]) <= 2.0);
+    }
+}
@@ -0,0 +1,162 @@
+#include <catch2/catch.hpp>
+
+#include <jive/range.h>
+#include "tau/color.h"
+#include "tau/interleave.h"
+#include "tau/planar.h"
+#include "tau/random.h"
+
+
+template<typename T, size_t count>
+void CheckInterleave(tau::Seed seed, Eigen::Index pixelCount)
+{
+    auto random = tau::UniformRandom<int>(seed, 0, 255);
+
+    std::array<std::vector<T>, count> planes;
+    std::array<const T *, count> sources;
+    std::array<T *, count> targets;
+    std::array<std::vector<T>, count> recovered;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (auto j: jive::Range<Eigen::Index>(0, pixelCount))
+        {
+            (void)j;
+            planes[i].push_back(static_cast<T>(random()));
+        }
+
+        recovered[i].resize(planes[i].size());
+        sources[i] = planes[i].data();
+        targets[i] = recovered[i].data();
+    }
+
+    std::vector<T> interleaved(count * planes[0].size());
+    tau::Interleave<count>(sources, interleaved.data(), pixelCount);
+
+    for (auto j: jive::Range<size_t>(0, planes[0].size()))
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            REQUIRE(interleaved[j * count + i] == planes[i][j]);
+        }
+    }
+
+    tau::Deinterleave<count>(interleaved.data(), targets, pixelCount);
+
+    REQUIRE(recovered == planes);
+}
+
+
+TEMPLATE_TEST_CASE(
+    "Interleave and deinterleave",
+    "[planar]",
+    uint8_t,
+    uint16_t,
+    float)
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto pixelCount = GENERATE(0, 1, 33, 1000);
+
+    CheckInterleave<TestType, 3>(seed, pixelCount);
+    CheckInterleave<TestType, 4>(seed, pixelCount);
+    CheckInterleave<TestType, 5>(seed, pixelCount);
+}
+
+
+TEST_CASE("Planar interleaved layouts", "[planar]")
+{
+    using ColumnMajor =
+        tau::Planar<3, uint16_t, Eigen::Dynamic, Eigen::Dynamic>;
+
+    using RowMajor = tau::Planar
+        <
+            3,
+            uint16_t,
+            Eigen::Dynamic,
+            Eigen::Dynamic,
+            Eigen::RowMajor
+        >;
+
+    ColumnMajor planar(5, 7);
+
+    for (auto i: jive::Range<Eigen::Index>(0, 3))
+    {
+        for (auto row: jive::Range<Eigen::Index>(0, 5))
+        {
+            for (auto column: jive::Range<Eigen::Index>(0, 7))
+            {
+                planar.planes[size_t(i)](row, column) =
+                    static_cast<uint16_t>(1000 * i + 10 * row + column);
+            }
+        }
+    }
+
+    auto columns = planar.GetInterleaved();
+    auto rows = planar.GetInterleaved<Eigen::RowMajor>();
+
+    REQUIRE(columns.rows() == 3);
+    REQUIRE(rows.cols() == 3);
+
+    // Pixels follow the storage order of the planes.
+    REQUIRE(columns(1, 1) == 1010);
+    REQUIRE(rows(1, 1) == 1010);
+    REQUIRE(columns(2, 5) == 2001);
+
+    REQUIRE(
+        ColumnMajor::FromInterleaved(columns, 5, 7).planes == planar.planes);
+
+    REQUIRE(
+        ColumnMajor::FromInterleaved(rows, 5, 7).planes == planar.planes);
+
+    // The transposed expressions take the general path.
+    Eigen::Matrix<uint16_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        planarLayout = columns;
+
+    REQUIRE(
+        ColumnMajor::FromInterleaved(planarLayout, 5, 7).planes
+            == planar.planes);
+
+    RowMajor rowMajor = RowMajor::FromInterleaved(rows, 5, 7);
+
+    // Row-major planes take the pixels in row-major order.
+    REQUIRE(
+        rowMajor.planes[2]
+            == rows.col(2).reshaped<Eigen::RowMajor>(5, 7));
+    REQUIRE(rowMajor.GetInterleaved() == rows);
+}
+
+
+TEST_CASE("Pixels round trip through Planar", "[planar]")
+{
+    using Pixels = tau::RgbaPixels<uint8_t>;
+
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto random = tau::UniformRandom<int>(seed, 0, 255);
+
+    typename Pixels::PlanarType planar(9, 13);
+
+    for (auto &plane: planar.planes)
+    {
+        for (auto i: jive::Range<Eigen::Index>(0, plane.size()))
+        {
+            plane.data()[i] = static_cast<uint8_t>(random());
+        }
+    }
+
+    auto pixels = Pixels::Create(planar);
+
+    REQUIRE(pixels.data.rows() == 9 * 13);
+    REQUIRE(pixels.data(14, 2) == planar.planes[2](1, 1));
+    REQUIRE(pixels.GetPlanar().planes == planar.planes);
+
+    typename Pixels::PlanarType reused(9, 13);
+    auto storage = reused.planes[0].data();
+    pixels.GetPlanar(reused);
+
+    REQUIRE(reused.planes[0].data() == storage);
+    REQUIRE(reused.planes == planar.planes);
+}
@@ -0,0 +1,142 @@
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include <jive/range.h>
+#include "tau/color.h"
+#include "tau/planar_view.h"
+#include "tau/random.h"
+
+
+using View = tau::PlanarView<3, uint8_t, Eigen::RowMajor>;
+
+
+template<typename Planes>
+void Fill(tau::Seed seed, Planes &planes)
+{
+    // A coarse range makes ties between the planes common.
+    auto random = tau::UniformRandom<int>(seed, 0, 4);
+
+    for (auto &plane: planes.planes)
+    {
+        for (auto i: jive::Range<Eigen::Index>(0, plane.rows()))
+        {
+            for (auto j: jive::Range<Eigen::Index>(0, plane.cols()))
+            {
+                plane(i, j) = static_cast<uint8_t>(60 * random());
+            }
+        }
+    }
+}
+
+
+TEST_CASE("PlanarView wraps a buffer with a plane stride", "[planar]")
+{
+    // Two padding samples follow each 3 x 4 plane.
+    std::vector<uint8_t> buffer(3 * 14);
+    std::iota(buffer.begin(), buffer.end(), uint8_t{0});
+
+    View view(buffer.data(), 3, 4, 14);
+
+    REQUIRE(view.GetRowCount() == 3);
+    REQUIRE(view.GetColumnCount() == 4);
+    REQUIRE(view.planes[0](0, 1) == 1);
+    REQUIRE(view.planes[1](0, 0) == 14);
+    REQUIRE(view.planes[2](2, 3) == 28 + 11);
+
+    view.planes[1](1, 0) = 200;
+    REQUIRE(buffer[14 + 4] == 200);
+
+    tau::PlanarView<3, const uint8_t, Eigen::RowMajor> constView(
+        buffer.data(),
+        3,
+        4,
+        14);
+
+    REQUIRE(constView.GetVector(1, 0) == Eigen::Vector3<uint8_t>(4, 200, 32));
+
+    REQUIRE_THROWS_AS(
+        View(buffer.data(), 3, 4, 11),
+        tau::PlanarError);
+}
+
+
+TEST_CASE("PlanarView algorithms match Planar", "[planar]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    tau::ContiguousPlanar<3, uint8_t, Eigen::RowMajor> contiguous(17, 29);
+    auto &view = contiguous.GetView();
+    Fill(seed, view);
+
+    auto planar = view.ToPlanar();
+
+    REQUIRE(planar.planes[2] == view.planes[2]);
+
+    using Planar = decltype(planar);
+    typename Planar::ExtremaIndices expectedIndices(17, 29);
+    typename View::ExtremaIndices indices(17, 29);
+
+    auto expected = planar.GetExtrema(&expectedIndices);
+    auto extrema = view.GetExtrema(&indices);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        REQUIRE(extrema.planes[i] == expected.planes[i]);
+        REQUIRE(indices.planes[i] == expectedIndices.planes[i]);
+    }
+
+    auto cast = view.Cast<float>();
+    REQUIRE(cast.planes[1] == planar.planes[1].cast<float>());
+
+    auto expectedHsv = tau::RgbToHsv<double>(planar);
+    auto hsv = tau::RgbToHsv<double>(view);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(hsv.planes[i] == expectedHsv.planes[i]);
+    }
+
+    // Convert directly into a view.
+    tau::ContiguousPlanar<3, double, Eigen::RowMajor> hsvStorage(17, 29);
+    tau::RgbToHsv(view, hsvStorage.GetView());
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(hsvStorage.GetView().planes[i] == expectedHsv.planes[i]);
+    }
+}
+
+
+TEST_CASE("ContiguousPlanar aligns each plane", "[planar]")
+{
+    using Contiguous = tau::ContiguousPlanar<4, uint16_t>;
+
+    Contiguous contiguous(7, 9);
+    auto &view = contiguous.GetView();
+
+    REQUIRE(view.GetPlaneStride() == 64);
+    REQUIRE(contiguous.GetByteCount() == 4 * 64 * sizeof(uint16_t));
+
+    for (auto &plane: view.planes)
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(plane.data());
+        REQUIRE(address % Contiguous::planeAlignment == 0);
+    }
+
+    REQUIRE(view.planes[3].data() == contiguous.GetData() + 3 * 64);
+
+    tau::Planar<4, uint16_t, Eigen::Dynamic, Eigen::Dynamic> planar(7, 9);
+
+    for (auto &plane: planar.planes)
+    {
+        plane.setConstant(42);
+    }
+
+    view.Assign(planar);
+
+    const Contiguous &constContiguous = contiguous;
+    REQUIRE(constContiguous.GetView().planes[3](6, 8) == 42);
+}
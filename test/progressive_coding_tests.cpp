@@ -0,0 +1,110 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <tau/progressive_coding.h>
+#include <tau/wavelet_compression.h>
+#include "wavelet_signal.h"
+
+
+double GetCoefficientRms(
+    const tau::Decomposed<double> &left,
+    const tau::Decomposed<double> &right)
+{
+    double squaredError = 0.0;
+    Eigen::Index count = 0;
+
+    for (size_t i = 0; i < left.size(); ++i)
+    {
+        squaredError += (left[i] - right[i]).squaredNorm();
+        count += left[i].size();
+    }
+
+    return std::sqrt(squaredError / static_cast<double>(count));
+}
+
+
+TEST_CASE("Progressive coding round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    int minimumBitPlane = GENERATE(-6, 0, 3);
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+
+    std::stringstream stream;
+    tau::EncodeProgressive(stream, decomposed, minimumBitPlane);
+    auto decoded = tau::DecodeProgressive(stream);
+
+    REQUIRE(decoded.size() == decomposed.size());
+
+    double bitPlaneValue = std::ldexp(1.0, minimumBitPlane);
+
+    for (size_t i = 0; i < decoded.size(); ++i)
+    {
+        REQUIRE(decoded[i].size() == decomposed[i].size());
+
+        Eigen::ArrayXd error =
+            (decoded[i] - decomposed[i]).array().abs().transpose();
+
+        // Coded coefficients are within half of the last bit-plane.
+        // Uncoded coefficients are smaller than the last bit-plane.
+        REQUIRE((error <= bitPlaneValue).all());
+    }
+}
+
+
+TEST_CASE("Truncated progressive streams improve with size", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db6);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+
+    std::ostringstream output;
+    tau::EncodeProgressive(output, decomposed, -2);
+    auto encoded = output.str();
+
+    double previousRms = std::numeric_limits<double>::max();
+
+    for (size_t size = 32; size < encoded.size(); size += encoded.size() / 8)
+    {
+        std::istringstream input(encoded.substr(0, size));
+        auto decoded = tau::DecodeProgressive(input);
+        double rms = GetCoefficientRms(decoded, decomposed);
+
+        REQUIRE(rms <= previousRms);
+        previousRms = rms;
+    }
+
+    // A budget stops the encoder at the same prefix.
+    size_t budget = encoded.size() / 3;
+    std::ostringstream limited;
+    tau::EncodeProgressive(limited, decomposed, -2, budget);
+
+    REQUIRE(limited.str().size() == budget);
+    REQUIRE(limited.str() == encoded.substr(0, budget));
+}
+
+
+TEST_CASE("Progressive coding of zeros", "[wavelet]")
+{
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    tau::Decomposed<double> decomposed{
+        RowVector::Zero(4),
+        RowVector::Zero(4),
+        RowVector::Zero(9)};
+
+    std::stringstream stream;
+    tau::EncodeProgressive(stream, decomposed);
+    auto decoded = tau::DecodeProgressive(stream);
+
+    REQUIRE(decoded.size() == 3);
+    REQUIRE(decoded[2].size() == 9);
+    REQUIRE(decoded[2].isZero());
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <tau/rate_control.h>
+#include "wavelet_signal.h"
+
+
+TEST_CASE("Rate estimate matches encoded size", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    double threshold = GENERATE(0.0, 0.7, 1.0, 2.5, 10.0, 80.0, 1e6);
+    bool enableMultibyteZeros = GENERATE(true, false);
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+
+    auto estimate = tau::EstimateRate(
+        decomposed,
+        threshold,
+        signal.size(),
+        enableMultibyteZeros);
+
+    tau::ApplyRate(decomposed, estimate);
+
+    std::ostringstream output;
+    tau::Encode(output, decomposed, enableMultibyteZeros);
+
+    REQUIRE(estimate.byteCount == output.str().size());
+}
+
+
+TEST_CASE("Find threshold for a byte budget", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    size_t budget = GENERATE(50u, 150u, 400u, 100000u);
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+
+    auto estimate = tau::FindThresholdForSize(
+        decomposed,
+        signal.size(),
+        budget);
+
+    REQUIRE(estimate.byteCount <= budget);
+
+    tau::ApplyRate(decomposed, estimate);
+
+    std::ostringstream output;
+    tau::Encode(output, decomposed, true);
+
+    REQUIRE(output.str().size() == estimate.byteCount);
+}
+
+
+TEST_CASE("Find threshold for an RMS error", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    double maximumRms = GENERATE(2.0, 5.0, 20.0);
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+
+    auto estimate = tau::FindThresholdForRms(
+        decomposed,
+        signal.size(),
+        maximumRms);
+
+    REQUIRE(estimate.rms <= maximumRms);
+
+    double quantize = tau::ApplyRate(decomposed, estimate);
+
+    for (auto &row: decomposed)
+    {
+        row.array() *= quantize;
+    }
+
+    auto recomposed = tau::Recompose(wavelet, decomposed, true);
+    double rms = tau::GetRms(recomposed.head(signal.size()) - signal);
+
+    // The estimate ignores boundary effects of the reflected extension.
+    REQUIRE(rms == Approx(estimate.rms).epsilon(0.1));
+}
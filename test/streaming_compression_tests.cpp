@@ -0,0 +1,193 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <tau/streaming_compression.h>
+#include "wavelet_signal.h"
+
+
+using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+
+RowVector MakeStreamingSignal(tau::Seed seed, Eigen::Index repeatCount)
+{
+    auto signal = MakeTestSignal(seed);
+    RowVector result(signal.size() * repeatCount);
+
+    for (Eigen::Index i = 0; i < repeatCount; ++i)
+    {
+        result.segment(i * signal.size(), signal.size()) = signal;
+    }
+
+    return result;
+}
+
+
+// Compresses in chunks of chunkSize, and decompresses each frame as it
+// arrives.
+RowVector RoundTrip(
+    const RowVector &signal,
+    const tau::StreamingSettings &settings,
+    Eigen::Index chunkSize,
+    std::vector<std::string> &frames)
+{
+    tau::StreamingCompressor compressor(settings);
+
+    for (Eigen::Index i = 0; i < signal.size(); i += chunkSize)
+    {
+        auto count = std::min(chunkSize, signal.size() - i);
+
+        for (auto &frame: compressor.Push(signal.segment(i, count)))
+        {
+            frames.push_back(frame);
+        }
+    }
+
+    for (auto &frame: compressor.Finish())
+    {
+        frames.push_back(frame);
+    }
+
+    tau::StreamingDecompressor decompressor(settings);
+    RowVector result(0);
+
+    for (auto &frame: frames)
+    {
+        RowVector samples = decompressor.Push(frame);
+        auto size = result.size();
+        result.conservativeResize(size + samples.size());
+        result.tail(samples.size()) = samples;
+    }
+
+    return result;
+}
+
+
+TEST_CASE("Streaming analysis matches Decompose", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto waveletName = GENERATE(
+        tau::WaveletName::db1,
+        tau::WaveletName::db4,
+        tau::WaveletName::db9);
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(waveletName);
+    auto decomposed = tau::Decompose(wavelet, signal, false, 1);
+
+    // Feed the signal in blocks of uneven size.
+    tau::detail::AnalysisStage stage(wavelet.decompose);
+    RowVector approximation(0);
+    RowVector detail(0);
+    Eigen::Index blockSize = 2;
+    Eigen::Index position = 0;
+
+    while (position < signal.size())
+    {
+        auto count = std::min(blockSize, signal.size() - position);
+        stage.Process(signal.segment(position, count), approximation, detail);
+        position += count;
+        blockSize += 6;
+    }
+
+    // Away from the end, where Decompose pads, the coefficients agree.
+    auto count = decomposed[1].size() - wavelet.decompose.low.size();
+
+    REQUIRE(approximation.head(count).isApprox(decomposed[0].head(count)));
+    REQUIRE(detail.head(count).isApprox(decomposed[1].head(count)));
+}
+
+
+TEST_CASE("Streaming compression round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto settings = tau::StreamingSettings::Default();
+    settings.keepRatio = 1.0;
+
+    settings.wavelet = GENERATE(
+        tau::WaveletName::db1,
+        tau::WaveletName::db4,
+        tau::WaveletName::db12);
+
+    settings.levelCount = GENERATE(1u, 3u, 5u);
+    settings.frameLength = 256;
+    settings.enableGroupVarint = GENERATE(false, true);
+
+    // A length that does not fill the last frame.
+    RowVector signal = MakeStreamingSignal(seed, 3).head(3000);
+
+    std::vector<std::string> frames;
+    auto recovered = RoundTrip(signal, settings, 100, frames);
+
+    REQUIRE(recovered.size() == signal.size());
+
+    // Keeping every coefficient leaves only the quantization error.
+    REQUIRE(tau::GetRms(recovered - signal) < 1.0);
+}
+
+
+TEST_CASE("Streaming frames do not depend on chunk size", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    auto settings = tau::StreamingSettings::Default();
+    RowVector signal = MakeStreamingSignal(seed, 4);
+
+    std::vector<std::string> whole;
+    std::vector<std::string> chunked;
+
+    auto fromWhole = RoundTrip(signal, settings, signal.size(), whole);
+    auto fromChunks = RoundTrip(signal, settings, 37, chunked);
+
+    REQUIRE(whole == chunked);
+    REQUIRE(fromWhole == fromChunks);
+    REQUIRE(fromWhole.size() == signal.size());
+}
+
+
+TEST_CASE("Streaming settings are checked", "[wavelet]")
+{
+    auto settings = tau::StreamingSettings::Default();
+    settings.levelCount = 4;
+    settings.frameLength = 100;
+
+    REQUIRE_THROWS_AS(
+        tau::StreamingCompressor(settings),
+        std::invalid_argument);
+
+    settings.levelCount = 0;
+
+    REQUIRE_THROWS_AS(
+        tau::StreamingDecompressor(settings),
+        std::invalid_argument);
+}
+
+
+TEST_CASE("Streaming frames with corrupt sample counts", "[wavelet]")
+{
+    auto settings = tau::StreamingSettings::Default();
+    RowVector signal = MakeStreamingSignal(3, 2);
+
+    std::vector<std::string> frames;
+    RoundTrip(signal, settings, signal.size(), frames);
+    REQUIRE(!frames.empty());
+
+    // Replace the sample count that begins the first frame.
+    std::istringstream input(frames.front());
+    tau::ReadVarint(input);
+    auto payload = frames.front().substr(static_cast<size_t>(input.tellg()));
+
+    std::ostringstream corrupt;
+    tau::WriteVarint(corrupt, uint64_t{1} << 63);
+    corrupt << payload;
+
+    tau::StreamingDecompressor decompressor(settings);
+
+    REQUIRE_THROWS_AS(
+        decompressor.Push(corrupt.str()),
+        std::runtime_error);
+}
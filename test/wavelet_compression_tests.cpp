@@ -0,0 +1,390 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <vector>
+#include <jive/binary_io.h>
+#include <tau/wavelet_compression.h>
+#include "wavelet_signal.h"
+
+
+tau::Decomposed<double> MakeQuantized(tau::Seed seed, double keepRatio)
+{
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+    double threshold = tau::PreserveHighest(decomposed, keepRatio);
+    tau::Quantize(decomposed, threshold);
+
+    return decomposed;
+}
+
+
+bool IsEqual(
+    const tau::Decomposed<double> &left,
+    const tau::Decomposed<double> &right)
+{
+    if (left.size() != right.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < left.size(); ++i)
+    {
+        if (left[i] != right[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+TEST_CASE("Varint round trip", "[wavelet]")
+{
+    uint64_t value = GENERATE(
+        0u,
+        1u,
+        127u,
+        128u,
+        16383u,
+        16384u,
+        65535u,
+        65536u,
+        std::numeric_limits<uint32_t>::max(),
+        std::numeric_limits<uint64_t>::max());
+
+    std::stringstream stream;
+    tau::WriteVarint(stream, value);
+    REQUIRE(tau::ReadVarint(stream) == value);
+}
+
+
+TEST_CASE("Varint wider than 64 bits is rejected", "[wavelet]")
+{
+    // Nine bytes of continued payload, then a tenth byte with bits that do
+    // not fit.
+    std::string bytes(9, '\xFF');
+    bytes.push_back(GENERATE('\x02', '\x7F'));
+
+    std::stringstream stream(bytes);
+    REQUIRE_THROWS_AS(tau::ReadVarint(stream), std::runtime_error);
+
+    // An eleventh byte is rejected even when the tenth carries only bit 0.
+    std::string continued(9, '\xFF');
+    continued += "\x81\x00";
+
+    std::stringstream continuedStream(continued);
+    REQUIRE_THROWS_AS(tau::ReadVarint(continuedStream), std::runtime_error);
+}
+
+
+TEST_CASE("Encode and decode round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(5, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    bool enableMultibyteZeros = GENERATE(true, false);
+    auto decomposed = MakeQuantized(seed, 0.1);
+
+    std::stringstream stream;
+    tau::Encode(stream, decomposed, enableMultibyteZeros);
+
+    // Versioned streams carry their own flags.
+    auto decoded = tau::Decode(stream, !enableMultibyteZeros);
+
+    REQUIRE(IsEqual(decoded, decomposed));
+}
+
+
+TEST_CASE("Rows longer than 65535 coefficients", "[wavelet]")
+{
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    bool enableMultibyteZeros = GENERATE(true, false);
+
+    tau::Decomposed<double> decomposed{
+        RowVector::Zero(3),
+        RowVector::Zero(100000),
+        RowVector::Zero(70000)};
+
+    decomposed[0] << 1, -40, 300;
+    decomposed[1](0) = 7;
+    decomposed[1](65536) = -70000;
+    decomposed[1](99999) = 123456;
+    decomposed[2](40000) = -2;
+
+    std::stringstream stream;
+    tau::Encode(stream, decomposed, enableMultibyteZeros);
+    auto decoded = tau::Decode(stream, enableMultibyteZeros);
+
+    REQUIRE(IsEqual(decoded, decomposed));
+}
+
+
+TEST_CASE("Decode the unversioned layout", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(5, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    bool enableMultibyteZeros = GENERATE(true, false);
+    auto decomposed = MakeQuantized(seed, 0.1);
+
+    std::stringstream stream;
+    jive::io::Write(stream, static_cast<uint8_t>(decomposed.size()));
+
+    for (auto &row: decomposed)
+    {
+        jive::io::Write(stream, static_cast<uint16_t>(row.size()));
+    }
+
+    for (auto &row: decomposed)
+    {
+        tau::EncodeRow(stream, row, enableMultibyteZeros);
+    }
+
+    auto decoded = tau::Decode(stream, enableMultibyteZeros);
+
+    REQUIRE(IsEqual(decoded, decomposed));
+}
+
+
+TEST_CASE("Encode zero runs at block boundaries", "[wavelet]")
+{
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    bool enableMultibyteZeros = GENERATE(true, false);
+
+    Eigen::Index runLength = GENERATE(
+        1, 15, 16, 17, 126, 127, 128, 254, 16382, 16383, 16384, 40000);
+
+    // One value of each width, separated and followed by zero runs.
+    std::vector<double> values{5, -100, 20000, -3000000000.0, 1e12};
+
+    auto valueCount = static_cast<Eigen::Index>(values.size());
+    RowVector row = RowVector::Zero(valueCount * (runLength + 1) + runLength);
+    size_t expectedSize = 0;
+
+    for (Eigen::Index i = 0; i < valueCount; ++i)
+    {
+        auto value = values[static_cast<size_t>(i)];
+        row((i + 1) * (runLength + 1) - 1) = value;
+
+        expectedSize += tau::GetZeroRunSize(
+            static_cast<size_t>(runLength),
+            enableMultibyteZeros);
+
+        expectedSize += tau::GetValueSize(static_cast<int64_t>(value));
+    }
+
+    expectedSize += tau::GetZeroRunSize(
+        static_cast<size_t>(runLength),
+        enableMultibyteZeros);
+
+    std::stringstream stream;
+    tau::EncodeRow(stream, row, enableMultibyteZeros);
+
+    REQUIRE(stream.str().size() == expectedSize);
+
+    auto decoded = tau::DecodeRow(
+        stream,
+        static_cast<size_t>(row.size()),
+        enableMultibyteZeros);
+
+    REQUIRE(decoded == row);
+}
+
+
+TEST_CASE("Group varint round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(5, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    double keepRatio = GENERATE(0.05, 1.0);
+    auto decomposed = MakeQuantized(seed, keepRatio);
+
+    std::stringstream stream;
+    tau::Encode(stream, decomposed, true, true);
+
+    // The row coding is read from the flags.
+    auto decoded = tau::Decode(stream, false);
+
+    REQUIRE(IsEqual(decoded, decomposed));
+}
+
+
+TEST_CASE("Group varint values of every width", "[wavelet]")
+{
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    // Row lengths cover full groups and every partial group.
+    Eigen::Index length = GENERATE(1, 2, 3, 4, 5, 11);
+    bool hasWide = GENERATE(false, true);
+
+    std::vector<double> values{
+        0, -1, 127, -128, 128, -32768, 32767, 40000, -2147483648.0};
+
+    if (hasWide)
+    {
+        values.push_back(-3000000000.0);
+        values.push_back(1e15);
+    }
+
+    RowVector row(length);
+
+    for (Eigen::Index i = 0; i < length; ++i)
+    {
+        row(i) = values[static_cast<size_t>(i) % values.size()];
+    }
+
+    if (hasWide)
+    {
+        row(length - 1) = values.back();
+    }
+
+    std::stringstream stream;
+    tau::EncodeGroupRow(stream, row);
+    stream.put('\x7E');
+
+    auto decoded = tau::DecodeGroupRow(stream, static_cast<size_t>(length));
+
+    REQUIRE(decoded == row);
+
+    // The row consumed exactly its own bytes.
+    REQUIRE(stream.get() == 0x7E);
+}
+
+
+TEST_CASE("Float coefficients round trip", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    bool enableGroupVarint = GENERATE(false, true);
+
+    auto signal = MakeTestSignal(seed).cast<float>().eval();
+    auto wavelet = tau::GetWavelet<float>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+    double threshold = tau::PreserveHighest(decomposed, 0.1);
+    tau::Quantize(decomposed, threshold);
+
+    std::stringstream stream;
+    tau::Encode(stream, decomposed, true, enableGroupVarint);
+    auto decoded = tau::Decode<float>(stream, true);
+
+    REQUIRE(decoded.size() == decomposed.size());
+
+    for (size_t i = 0; i < decoded.size(); ++i)
+    {
+        REQUIRE(decoded[i] == decomposed[i]);
+    }
+}
+
+
+TEST_CASE("Quantize to int32_t", "[wavelet]")
+{
+    auto seed = GENERATE(
+        take(3, random(0u, std::numeric_limits<unsigned int>::max())));
+
+    bool enableGroupVarint = GENERATE(false, true);
+
+    auto signal = MakeTestSignal(seed);
+    auto wavelet = tau::GetWavelet<double>(tau::WaveletName::db4);
+    auto decomposed = tau::Decompose(wavelet, signal, true);
+    double threshold = tau::PreserveHighest(decomposed, 0.1);
+
+    tau::Decomposed<int32_t> quantized;
+    double quantize = tau::Quantize(decomposed, quantized, threshold);
+
+    REQUIRE(quantize == tau::Quantize(decomposed, threshold));
+
+    for (size_t i = 0; i < quantized.size(); ++i)
+    {
+        REQUIRE(quantized[i].cast<double>() == decomposed[i]);
+    }
+
+    // The integer stream matches the stream written from doubles.
+    std::ostringstream fromIntegers;
+    std::ostringstream fromDoubles;
+    tau::Encode(fromIntegers, quantized, true, enableGroupVarint);
+    tau::Encode(fromDoubles, decomposed, true, enableGroupVarint);
+
+    REQUIRE(fromIntegers.str() == fromDoubles.str());
+
+    std::istringstream input(fromIntegers.str());
+    auto decoded = tau::Decode<int32_t>(input, true);
+
+    REQUIRE(decoded == quantized);
+}
+
+
+TEST_CASE("Quantize rejects coefficients that do not fit", "[wavelet]")
+{
+    tau::Decomposed<int32_t> quantized;
+
+    // -2^31 fits, and 2^31 is exactly representable as a float.
+    tau::Decomposed<float> lowest{Eigen::RowVectorXf::Constant(4, -0x1p31f)};
+    tau::Quantize(lowest, quantized, 0.0);
+    REQUIRE(quantized.at(0)(0) == std::numeric_limits<int32_t>::min());
+
+    tau::Decomposed<float> decomposed{Eigen::RowVectorXf::Zero(4)};
+    decomposed[0](1) = GENERATE(
+        0x1p31f,
+        -0x1p32f,
+        std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::infinity());
+
+    REQUIRE_THROWS_AS(
+        tau::Quantize(decomposed, quantized, 0.0),
+        std::runtime_error);
+}
+
+
+TEST_CASE("Decoding to int32_t rejects wide values", "[wavelet]")
+{
+    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
+
+    bool enableGroupVarint = GENERATE(false, true);
+
+    tau::Decomposed<double> decomposed{RowVector::Constant(3, 1e10)};
+
+    std::stringstream stream;
+    tau::Encode(stream, decomposed, true, enableGroupVarint);
+
+    REQUIRE_THROWS_AS(tau::Decode<int32_t>(stream, true), std::runtime_error);
+}
+
+
+TEST_CASE("Decoding rejects row lengths that do not fit", "[wavelet]")
+{
+    bool enableGroupVarint = GENERATE(false, true);
+
+    std::stringstream stream;
+
+    for (auto byte: tau::format::magic)
+    {
+        jive::io::Write(stream, byte);
+    }
+
+    jive::io::Write(stream, tau::format::version);
+
+    jive::io::Write(
+        stream,
+        enableGroupVarint ? tau::format::groupVarint : uint8_t{0});
+
+    // One row of 2^63 coefficients.
+    tau::WriteVarint(stream, 1u);
+    tau::WriteVarint(stream, uint64_t{1} << 63);
+
+    REQUIRE_THROWS_AS(tau::Decode<double>(stream, true), std::runtime_error);
+
+    std::stringstream rowStream;
+
+    REQUIRE_THROWS_AS(
+        tau::DecodeRow<double>(rowStream, SIZE_MAX, true),
+        std::runtime_error);
+
+    REQUIRE_THROWS_AS(
+        tau::DecodeGroupRow<double>(rowStream, SIZE_MAX),
+        std::runtime_error);
+}
@@ -2,43 +2,7 @@
 #include <tau/wavelet.h>
 #include <tau/random.h>
 #include <tau/angles.h>
-
-
-Eigen::RowVector<double, Eigen::Dynamic> MakeTestSignal(tau::Seed seed)
-{
-    using RowVector = Eigen::RowVector<double, Eigen::Dynamic>;
-    using Eigen::Index;
-    using Eigen::seqN;
-
-    Index length = 1024;
-    auto pi = tau::Angles<double>::pi;
-    RowVector x = RowVector::LinSpaced(length, 0, 2 * pi);
-
-    RowVector y = 100 * Eigen::sin(2 * x.array() - pi / 8);
-    RowVector p = 900 * Eigen::cos(300 * x.array());
-    RowVector q = 75 * Eigen::cos(101 * x.array());
-    RowVector r = 50 * Eigen::cos(72 * x.array());
-
-    for (auto [start, width, u]: {
-            std::make_tuple(135, 357, &p),
-            std::make_tuple(195, 212, &q),
-            std::make_tuple(240, 250, &r)})
-    {
-        y(seqN(start, width)) += (*u)(seqN(start, width));
-    }
-
-    y(seqN(0, 150)).array() = 0;
-    y.tail(length - 300).array() = 0;
-
-    auto random = tau::UniformRandom<double>(seed, -5, 5);
-
-    for (ssize_t i = 0; i < y.size(); ++i)
-    {
-        y(i) += random();
-    }
-
-    return y;
-}
+#include "wavelet_signal.h"
 
 
 Eigen::RowVector<double, Eigen::Dynamic> MakeSimpleTestSignal()
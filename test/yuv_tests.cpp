@@ -0,0 +1,379 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <tau/yuv.h>
+#include <tau/random.h>
+
+
+namespace
+{
+
+
+using Index = Eigen::Index;
+
+
+struct Weights
+{
+    double red;
+    double blue;
+};
+
+
+Weights GetWeights(tau::YuvStandard standard)
+{
+    if (standard == tau::YuvStandard::bt709)
+    {
+        return {0.2126, 0.0722};
+    }
+
+    return {0.299, 0.114};
+}
+
+
+// The exact conversion, before rounding.
+Eigen::Vector3d YuvToRgb(
+    double y,
+    double u,
+    double v,
+    const tau::YuvFormat &format)
+{
+    auto weights = GetWeights(format.standard);
+    auto green = 1.0 - weights.red - weights.blue;
+
+    u -= 128.0;
+    v -= 128.0;
+
+    if (format.range == tau::YuvRange::limited)
+    {
+        y = (y - 16.0) * 255.0 / 219.0;
+        u *= 255.0 / 224.0;
+        v *= 255.0 / 224.0;
+    }
+
+    Eigen::Vector3d result(
+        y + 2.0 * (1.0 - weights.red) * v,
+        y - (2.0 * weights.blue * (1.0 - weights.blue) * u
+            + 2.0 * weights.red * (1.0 - weights.red) * v) / green,
+        y + 2.0 * (1.0 - weights.blue) * u);
+
+    return result.cwiseMax(0.0).cwiseMin(255.0);
+}
+
+
+Eigen::Vector3d RgbToYuv(
+    const Eigen::Vector3d &rgb,
+    const tau::YuvFormat &format)
+{
+    auto weights = GetWeights(format.standard);
+    auto green = 1.0 - weights.red - weights.blue;
+
+    double y = weights.red * rgb(0) + green * rgb(1) + weights.blue * rgb(2);
+    double u = (rgb(2) - y) / (2.0 * (1.0 - weights.blue));
+    double v = (rgb(0) - y) / (2.0 * (1.0 - weights.red));
+
+    if (format.range == tau::YuvRange::limited)
+    {
+        y = 16.0 + y * 219.0 / 255.0;
+        u *= 224.0 / 255.0;
+        v *= 224.0 / 255.0;
+    }
+
+    return Eigen::Vector3d(y, u + 128.0, v + 128.0);
+}
+
+
+std::vector<uint8_t> MakeRandomBytes(unsigned seed, size_t count)
+{
+    auto uniformRandom = tau::UniformRandom<int>(seed, 0, 255);
+    std::vector<uint8_t> result(count);
+
+    for (auto &byte: result)
+    {
+        byte = static_cast<uint8_t>(uniformRandom());
+    }
+
+    return result;
+}
+
+
+} // end anonymous namespace
+
+
+TEST_CASE("NV12 and YUYV convert to RGB within one count", "[yuv]")
+{
+    auto seed = GENERATE(take(3, random(0u, 10000u)));
+    auto standard = GENERATE(tau::YuvStandard::bt601, tau::YuvStandard::bt709);
+    auto range = GENERATE(tau::YuvRange::full, tau::YuvRange::limited);
+    tau::YuvFormat format{standard, range};
+
+    tau::Size<Index> size(12, 6);
+
+    auto nv12Bytes = MakeRandomBytes(
+        seed,
+        static_cast<size_t>(tau::Nv12View<const uint8_t>::GetByteCount(size)));
+
+    auto nv12 = tau::Nv12View<const uint8_t>::Create(nv12Bytes.data(), size);
+
+    auto pixels = tau::RgbPixels<uint8_t>::Create(size);
+    tau::Nv12ToRgb(nv12, pixels, format);
+
+    auto yuyvBytes = MakeRandomBytes(
+        seed + 1,
+        static_cast<size_t>(tau::YuyvView<const uint8_t>::GetByteCount(size)));
+
+    auto yuyv = tau::YuyvView<const uint8_t>::Create(yuyvBytes.data(), size);
+
+    auto yuyvPixels = tau::RgbPixels<uint8_t>::Create(size);
+    tau::YuyvToRgb(yuyv, yuyvPixels, format);
+
+    for (Index row = 0; row < size.height; ++row)
+    {
+        for (Index column = 0; column < size.width; ++column)
+        {
+            Index pixel = row * size.width + column;
+            Index chroma = (row / 2) * size.width + (column / 2) * 2;
+
+            auto expected = YuvToRgb(
+                nv12.luma[pixel],
+                nv12.chroma[chroma],
+                nv12.chroma[chroma + 1],
+                format);
+
+            REQUIRE(
+                (pixels.data.row(pixel).cast<double>().transpose() - expected)
+                    .cwiseAbs().maxCoeff() <= 1.0);
+
+            const uint8_t *pair = yuyv.data + row * yuyv.stride + 2 * column;
+            auto isFirst = column % 2 == 0;
+
+            auto expectedYuyv = YuvToRgb(
+                pair[0],
+                isFirst ? pair[1] : pair[-1],
+                isFirst ? pair[3] : pair[1],
+                format);
+
+            REQUIRE(
+                (yuyvPixels.data.row(pixel).cast<double>().transpose()
+                    - expectedYuyv).cwiseAbs().maxCoeff() <= 1.0);
+        }
+    }
+}
+
+
+TEST_CASE("RGB converts to NV12 and YUYV within one count", "[yuv]")
+{
+    auto seed = GENERATE(take(3, random(0u, 10000u)));
+    auto standard = GENERATE(tau::YuvStandard::bt601, tau::YuvStandard::bt709);
+    auto range = GENERATE(tau::YuvRange::full, tau::YuvRange::limited);
+    tau::YuvFormat format{standard, range};
+
+    tau::Size<Index> size(8, 4);
+    auto bytes = MakeRandomBytes(seed, static_cast<size_t>(3 * size.GetArea()));
+    auto pixels = tau::RgbPixelsView<uint8_t>::Create(bytes.data(), size);
+
+    std::vector<uint8_t> nv12Bytes(
+        static_cast<size_t>(tau::Nv12View<uint8_t>::GetByteCount(size)));
+
+    auto nv12 = tau::Nv12View<uint8_t>::Create(nv12Bytes.data(), size);
+    tau::RgbToNv12(pixels, nv12, format);
+
+    std::vector<uint8_t> yuyvBytes(
+        static_cast<size_t>(tau::YuyvView<uint8_t>::GetByteCount(size)));
+
+    auto yuyv = tau::YuyvView<uint8_t>::Create(yuyvBytes.data(), size);
+    tau::RgbToYuyv(pixels, yuyv, format);
+
+    auto getRgb = [&](Index row, Index column) -> Eigen::Vector3d
+    {
+        return pixels.data.row(row * size.width + column)
+            .cast<double>().transpose();
+    };
+
+    for (Index row = 0; row < size.height; ++row)
+    {
+        for (Index column = 0; column < size.width; ++column)
+        {
+            auto expected = RgbToYuv(getRgb(row, column), format);
+
+            REQUIRE(
+                std::abs(nv12.luma[row * size.width + column] - expected(0))
+                <= 1.0);
+
+            REQUIRE(
+                std::abs(yuyv.data[row * yuyv.stride + 2 * column]
+                    - expected(0)) <= 1.0);
+        }
+    }
+
+    for (Index row = 0; row < size.height; row += 2)
+    {
+        for (Index column = 0; column < size.width; column += 2)
+        {
+            Eigen::Vector3d mean =
+                (getRgb(row, column) + getRgb(row, column + 1)
+                    + getRgb(row + 1, column) + getRgb(row + 1, column + 1))
+                / 4.0;
+
+            auto expected = RgbToYuv(mean, format);
+            const uint8_t *chroma = nv12.chroma + (row / 2) * size.width;
+
+            REQUIRE(std::abs(chroma[column] - expected(1)) <= 1.0);
+            REQUIRE(std::abs(chroma[column + 1] - expected(2)) <= 1.0);
+        }
+    }
+
+    for (Index row = 0; row < size.height; ++row)
+    {
+        for (Index column = 0; column < size.width; column += 2)
+        {
+            Eigen::Vector3d mean =
+                (getRgb(row, column) + getRgb(row, column + 1)) / 2.0;
+
+            auto expected = RgbToYuv(mean, format);
+            const uint8_t *pair = yuyv.data + row * yuyv.stride + 2 * column;
+
+            REQUIRE(std::abs(pair[1] - expected(1)) <= 1.0);
+            REQUIRE(std::abs(pair[3] - expected(2)) <= 1.0);
+        }
+    }
+}
+
+
+TEST_CASE("YUV reference colors", "[yuv]")
+{
+    tau::YuvFormat format{tau::YuvStandard::bt601, tau::YuvRange::limited};
+    tau::Size<Index> size(2, 2);
+
+    // Black, then white.
+    for (uint8_t luma: {uint8_t{16}, uint8_t{235}})
+    {
+        std::vector<uint8_t> bytes{luma, luma, luma, luma, 128, 128};
+        auto nv12 = tau::Nv12View<const uint8_t>::Create(bytes.data(), size);
+        auto pixels = tau::RgbPixels<uint8_t>::Create(size);
+        tau::Nv12ToRgb(nv12, pixels, format);
+
+        uint8_t expected = (luma == 16) ? 0 : 255;
+        REQUIRE((pixels.data.array() == expected).all());
+    }
+
+    // Pure red in BT.709 full range.
+    std::vector<uint8_t> red{255, 0, 0, 255, 0, 0};
+    auto pixels = tau::RgbPixelsView<uint8_t>::Create(red.data(), {{2, 1}});
+    std::vector<uint8_t> yuyvBytes(4);
+
+    tau::RgbToYuyv(
+        pixels,
+        tau::YuyvView<uint8_t>::Create(yuyvBytes.data(), {{2, 1}}),
+        {tau::YuvStandard::bt709, tau::YuvRange::full});
+
+    REQUIRE(yuyvBytes == std::vector<uint8_t>{54, 99, 54, 255});
+}
+
+
+TEST_CASE("YUV converts planes and row bands", "[yuv]")
+{
+    auto seed = GENERATE(take(3, random(0u, 10000u)));
+    tau::YuvFormat format{tau::YuvStandard::bt709, tau::YuvRange::limited};
+    tau::ThreadPool threadPool(4);
+
+    tau::Size<Index> size(64, 70);
+
+    auto nv12Bytes = MakeRandomBytes(
+        seed,
+        static_cast<size_t>(tau::Nv12View<const uint8_t>::GetByteCount(size)));
+
+    auto nv12 = tau::Nv12View<const uint8_t>::Create(nv12Bytes.data(), size);
+
+    auto pixels = tau::RgbPixels<uint8_t>::Create(size);
+    tau::Nv12ToRgb(nv12, pixels, format);
+
+    auto banded = tau::RgbPixels<uint8_t>::Create(size);
+    tau::Nv12ToRgb(nv12, banded, format, threadPool);
+    REQUIRE(banded.data == pixels.data);
+
+    using Planar = tau::Planar<3, uint8_t, Eigen::Dynamic, Eigen::Dynamic, 1>;
+    Planar planar(size.height, size.width);
+    tau::Nv12ToRgb(nv12, planar, format, threadPool);
+    REQUIRE(planar.GetInterleaved<Eigen::RowMajor>() == pixels.data);
+
+    std::vector<uint8_t> expected(nv12Bytes.size());
+    std::vector<uint8_t> fromPlanar(nv12Bytes.size());
+
+    tau::RgbToNv12(
+        pixels,
+        tau::Nv12View<uint8_t>::Create(expected.data(), size),
+        format);
+
+    tau::RgbToNv12(
+        planar,
+        tau::Nv12View<uint8_t>::Create(fromPlanar.data(), size),
+        format,
+        threadPool);
+
+    REQUIRE(fromPlanar == expected);
+
+    std::vector<uint8_t> yuyv(
+        static_cast<size_t>(tau::YuyvView<uint8_t>::GetByteCount(size)));
+
+    std::vector<uint8_t> yuyvBanded(yuyv.size());
+
+    tau::RgbToYuyv(
+        pixels,
+        tau::YuyvView<uint8_t>::Create(yuyv.data(), size),
+        format);
+
+    tau::RgbToYuyv(
+        pixels,
+        tau::YuyvView<uint8_t>::Create(yuyvBanded.data(), size),
+        format,
+        threadPool);
+
+    REQUIRE(yuyvBanded == yuyv);
+
+    auto yuyvView = tau::YuyvView<const uint8_t>::Create(yuyv.data(), size);
+    auto fromYuyv = tau::RgbPixels<uint8_t>::Create(size);
+    auto fromYuyvBanded = tau::RgbPixels<uint8_t>::Create(size);
+
+    tau::YuyvToRgb(yuyvView, fromYuyv, format);
+    tau::YuyvToRgb(yuyvView, fromYuyvBanded, format, threadPool);
+    REQUIRE(fromYuyvBanded.data == fromYuyv.data);
+}
+
+
+TEST_CASE("YUV requires even dimensions", "[yuv]")
+{
+    tau::YuvFormat format{tau::YuvStandard::bt601, tau::YuvRange::full};
+    std::vector<uint8_t> bytes(64);
+
+    auto pixels = tau::RgbPixels<uint8_t>::Create(tau::Size<Index>(3, 2));
+
+    REQUIRE_THROWS_AS(
+        tau::Nv12ToRgb(
+            tau::Nv12View<const uint8_t>::Create(
+                bytes.data(),
+                tau::Size<Index>(3, 2)),
+            pixels,
+            format),
+        std::invalid_argument);
+
+    REQUIRE_THROWS_AS(
+        tau::YuyvToRgb(
+            tau::YuyvView<const uint8_t>::Create(
+                bytes.data(),
+                tau::Size<Index>(3, 2)),
+            pixels,
+            format),
+        std::invalid_argument);
+
+    // The frame and pixels differ in size.
+    REQUIRE_THROWS_AS(
+        tau::YuyvToRgb(
+            tau::YuyvView<const uint8_t>::Create(
+                bytes.data(),
+                tau::Size<Index>(2, 2)),
+            pixels,
+            format),
+        std::invalid_argument);
+}